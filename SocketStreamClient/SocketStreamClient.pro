@@ -15,18 +15,44 @@ DEFINES += QT_DEPRECATED_WARNINGS
 # You can also select to disable deprecated APIs only up to a certain version of Qt.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(src/core.pri)
+
 SOURCES += \
-	src/bitdepthconverter.cpp \
-	src/datareceiver.cpp \
+	src/benchmark.cpp \
+	src/colormap.cpp \
+	src/framecache.cpp \
+	src/framerenderer.cpp \
+	src/framescrubbar.cpp \
 	src/imagedisplay.cpp \
+	src/imageitem.cpp \
+	src/lineplotprocessor.cpp \
+	src/lineplotwidget.cpp \
 	src/main.cpp \
-	src/socketstreamclient.cpp
+	src/memoryusage.cpp \
+	src/soaktest.cpp \
+	src/socketstreamclient.cpp \
+	src/spatialfilter.cpp \
+	src/testserver.cpp \
+	src/workerpool.cpp
 
 HEADERS += \
-	src/bitdepthconverter.h \
-	src/datareceiver.h \
+	src/benchmark.h \
+	src/colormap.h \
+	src/framecache.h \
+	src/framerenderer.h \
+	src/framescrubbar.h \
 	src/imagedisplay.h \
-	src/socketstreamclient.h
+	src/imageitem.h \
+	src/lineplotprocessor.h \
+	src/lineplotwidget.h \
+	src/memoryusage.h \
+	src/soaktest.h \
+	src/socketstreamclient.h \
+	src/spatialfilter.h \
+	src/testserver.h \
+	src/workerpool.h
+
+win32: LIBS += -lpsapi
 
 FORMS += \
 	src/socketstreamclient.ui
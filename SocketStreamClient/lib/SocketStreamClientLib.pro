@@ -0,0 +1,30 @@
+QT -= gui
+QT += core network
+
+TEMPLATE = lib
+TARGET = socketstreamclient
+
+CONFIG += c++11
+
+DEFINES += SOCKETSTREAMCLIENT_LIBRARY
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../src/core.pri)
+
+SOURCES += \
+	streamclient.cpp \
+	streamclient_c.cpp
+
+HEADERS += \
+	streamclient_global.h \
+	streamclient.h \
+	streamclient_c.h
+
+# Default rules for deployment.
+unix {
+	target.path = /usr/lib
+	headers.path = /usr/include/socketstreamclient
+	headers.files = streamclient_global.h streamclient.h streamclient_c.h # the core headers are internal
+	INSTALLS += headers
+}
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,327 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "streamclient.h"
+#include "bitdepthconverter.h"
+#include "datareceiver.h"
+#include "frame.h"
+#include "streamheader.h"
+#include "streamrequest.h"
+#include "streamstatistics.h"
+#include "threadtuning.h"
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QtMath>
+#include <thread>
+
+namespace {
+	//DataReceiver needs a QCoreApplication. Host applications that do not use Qt get one on a background thread that is shut down again together with the last StreamClient.
+	class CoreApplicationOwner
+	{
+	public:
+		~CoreApplicationOwner() {
+			//only reached with StreamClients that were never destroyed
+			if(this->thread.joinable()){
+				this->thread.detach();
+			}
+		}
+
+		void acquire() {
+			QMutexLocker locker(&this->mutex);
+			this->users++;
+			if(this->application != nullptr || QCoreApplication::instance() != nullptr){
+				return;
+			}
+			QSemaphore ready;
+			this->thread = std::thread([this, &ready]() {
+				static int argc = 1;
+				static char appName[] = "SocketStreamClient";
+				static char* argv[] = {appName, nullptr};
+				QCoreApplication app(argc, argv);
+				this->application = &app;
+				ready.release();
+				app.exec();
+			});
+			ready.acquire();
+		}
+
+		void release() {
+			QMutexLocker locker(&this->mutex);
+			this->users--;
+			if(this->users > 0 || this->application == nullptr){
+				return;
+			}
+			QMetaObject::invokeMethod(this->application, "quit", Qt::QueuedConnection);
+			this->thread.join();
+			this->application = nullptr;
+		}
+
+	private:
+		QMutex mutex;
+		int users = 0;
+		QCoreApplication* application = nullptr;
+		std::thread thread;
+	};
+
+	CoreApplicationOwner& coreApplicationOwner() {
+		static CoreApplicationOwner owner;
+		return owner;
+	}
+
+	StreamClientStatistics toClientStatistics(const StreamStatistics& statistics) {
+		StreamClientStatistics clientStatistics;
+		clientStatistics.framesReceived = statistics.framesReceived();
+		clientStatistics.framesLost = statistics.framesLost();
+		clientStatistics.framesReordered = statistics.framesReordered();
+		clientStatistics.meanLatencyMs = statistics.meanLatencyMs();
+		clientStatistics.minLatencyMs = statistics.minLatencyMs();
+		clientStatistics.maxLatencyMs = statistics.maxLatencyMs();
+		clientStatistics.latencyJitterMs = statistics.latencyJitterMs();
+		clientStatistics.arrivalJitterMs = statistics.arrivalJitterMs();
+		clientStatistics.framesChecked = statistics.framesChecked();
+		clientStatistics.checksumFailures = statistics.checksumFailures();
+		return clientStatistics;
+	}
+}
+
+
+StreamFrame::StreamFrame()
+{
+}
+
+StreamFrame::StreamFrame(QSharedPointer<FrameBuffer> frame) : frame(frame)
+{
+}
+
+bool StreamFrame::isValid() const {
+	return !this->frame.isNull();
+}
+
+const uchar* StreamFrame::data() const {
+	return this->frame.isNull() ? nullptr : this->frame->constData();
+}
+
+quint32 StreamFrame::sizeInBytes() const {
+	return this->frame.isNull() ? 0 : this->frame->size();
+}
+
+StreamFrameInfo StreamFrame::info() const {
+	StreamFrameInfo info = {};
+	if(this->frame.isNull()){
+		return info;
+	}
+	const FrameInfo& frameInfo = this->frame->info;
+	info.bitDepth = frameInfo.bitDepth;
+	info.sampleFormat = static_cast<int>(frameInfo.sampleFormat);
+	info.samplesPerLine = frameInfo.samplesPerLine;
+	info.linesPerFrame = frameInfo.linesPerFrame;
+	info.framesPerBuffer = frameInfo.framesPerBuffer;
+	info.sizeInBytes = frameInfo.sizeInBytes;
+	info.hasSequenceNumber = frameInfo.hasSequenceNumber;
+	info.sequenceNumber = frameInfo.sequenceNumber;
+	info.senderTimestampUs = frameInfo.senderTimestampUs;
+	info.receiveTimestampUs = frameInfo.receiveTimestampUs;
+	info.kernelReceiveTimestamp = frameInfo.kernelReceiveTimestamp;
+	info.checksumState = static_cast<int>(frameInfo.checksumState);
+	info.regionX = frameInfo.regionX;
+	info.regionY = frameInfo.regionY;
+	info.fullWidth = frameInfo.fullWidth;
+	info.fullHeight = frameInfo.fullHeight;
+	info.sampleStep = frameInfo.sampleStep;
+	info.lineStep = frameInfo.lineStep;
+	info.frameStep = frameInfo.frameStep;
+	return info;
+}
+
+bool StreamFrame::convertTo8bit(uchar* outputData, int outputSize) const {
+	if(this->frame.isNull() || outputData == nullptr){
+		return false;
+	}
+	qint64 frameLength = static_cast<qint64>(this->frame->info.samplesPerLine) * this->frame->info.linesPerFrame;
+	int bytesPerSample = qCeil(static_cast<double>(this->frame->info.bitDepth) / 8.0);
+	if(outputSize < frameLength || this->frame->size() < frameLength * bytesPerSample){
+		return false;
+	}
+	int length = static_cast<int>(frameLength);
+	int bitDepth = static_cast<int>(this->frame->info.bitDepth);
+	SampleFormat format = this->frame->info.sampleFormat;
+	if(format == SampleFormat::Unsigned){
+		return BitDepthConverter::convertTo8bit(this->frame->constData(), outputData, bitDepth, length);
+	}
+	//signed and float samples are normalized to the minimum and maximum of the frame
+	float minValue, maxValue;
+	return BitDepthConverter::findRange(this->frame->constData(), bitDepth, format, length, minValue, maxValue)
+			&& BitDepthConverter::convertTo8bit(this->frame->constData(), outputData, bitDepth, format, length, minValue, maxValue);
+}
+
+void StreamFrame::release() {
+	this->frame.clear();
+}
+
+
+
+StreamClient::StreamClient()
+{
+	coreApplicationOwner().acquire();
+	qRegisterMetaType<ReceiverParameters>("ReceiverParameters");
+	this->lastStatistics = toClientStatistics(StreamStatistics());
+
+	this->receiver = new DataReceiver();
+	this->receiver->moveToThread(&receiverThread);
+	QObject::connect(this->receiver, &DataReceiver::frameReceived, this->receiver, [this](Frame frame) { this->deliverFrame(frame); }, Qt::DirectConnection);
+	QObject::connect(this->receiver, &DataReceiver::connected, this->receiver, [this](bool connected) { this->connected.storeRelease(connected ? 1 : 0); }, Qt::DirectConnection);
+	QObject::connect(this->receiver, &DataReceiver::statisticsUpdated, this->receiver, [this](StreamStatistics statistics) {
+		StreamClientStatistics clientStatistics = toClientStatistics(statistics);
+		QMutexLocker locker(&this->statisticsMutex);
+		this->lastStatistics = clientStatistics;
+	}, Qt::DirectConnection);
+	QObject::connect(&receiverThread, &QThread::finished, this->receiver, &DataReceiver::deleteLater);
+	receiverThread.start();
+}
+
+StreamClient::~StreamClient()
+{
+	this->setFrameCallback(FrameCallback());
+	receiverThread.quit();
+	receiverThread.wait();
+	coreApplicationOwner().release();
+}
+
+void StreamClient::setFrameCallback(FrameCallback callback) {
+	QMutexLocker locker(&this->callbackMutex);
+	this->frameCallback = callback;
+}
+
+bool StreamClient::setReceiverThreadTuning(const QString& cpus, int numaNode, const QString& priority) {
+	ThreadTuning tuning;
+	tuning.numaNode = numaNode >= 0 ? numaNode : -1;
+	if(!cpus.isEmpty() && !ThreadTuning::parseCpuList(cpus, tuning.cpus)){
+		return false;
+	}
+	if(!priority.isEmpty() && !ThreadTuning::parsePriority(priority, tuning.policy, tuning.priority)){
+		return false;
+	}
+	tuning.applyToThreadOf(this->receiver, "receiver");
+	return true;
+}
+
+bool StreamClient::setStreamRequest(int x, int y, int width, int height, int sampleStep, int lineStep, int frameStep) {
+	const int positions[] = {x, y, width, height};
+	const int steps[] = {sampleStep, lineStep, frameStep};
+	for(int position : positions){
+		if(position < 0 || position > 65535){
+			return false;
+		}
+	}
+	for(int step : steps){
+		if(step < 1 || step > StreamRequest::MAX_STEP){
+			return false;
+		}
+	}
+	StreamRequest request;
+	request.x = static_cast<quint16>(x);
+	request.y = static_cast<quint16>(y);
+	request.width = static_cast<quint16>(width);
+	request.height = static_cast<quint16>(height);
+	request.sampleStep = static_cast<quint8>(sampleStep);
+	request.lineStep = static_cast<quint8>(lineStep);
+	request.frameStep = static_cast<quint8>(frameStep);
+	DataReceiver* receiver = this->receiver;
+	QMetaObject::invokeMethod(receiver, [receiver, request]() { receiver->setStreamRequest(request); }, Qt::QueuedConnection);
+	return true;
+}
+
+bool StreamClient::open(const StreamClientParameters& clientParams) {
+	if(clientParams.ip.isEmpty()){
+		return false;
+	}
+	if(clientParams.sampleFormat < static_cast<int>(SampleFormat::Unsigned) || clientParams.sampleFormat > static_cast<int>(SampleFormat::Float)){
+		return false;
+	}
+	ReceiverParameters params;
+	params.ip = clientParams.ip;
+	params.port = static_cast<qint16>(clientParams.port);
+	params.useHeaders = clientParams.useHeaders;
+	params.bitDepth = clientParams.bitDepth;
+	params.sampleFormat = static_cast<SampleFormat>(clientParams.sampleFormat);
+	params.samplesPerLine = clientParams.samplesPerLine;
+	params.linesPerFrame = clientParams.linesPerFrame;
+	params.framesPerBuffer = clientParams.framesPerBuffer;
+	//without headers the parameters describe the stream and are used to size the receive buffers
+	if(!params.useHeaders){
+		if(!StreamHeader::isValidSampleFormat(params.bitDepth, params.sampleFormat)){
+			return false;
+		}
+		if(params.samplesPerLine <= 0 || params.linesPerFrame <= 0 || params.framesPerBuffer <= 0){
+			return false;
+		}
+		qint64 bytesPerSample = qCeil(static_cast<double>(params.bitDepth) / 8.0);
+		qint64 bufferSize = static_cast<qint64>(params.samplesPerLine) * params.linesPerFrame * params.framesPerBuffer * bytesPerSample;
+		if(bufferSize >= StreamHeader::MAX_ALLOWED_SIZE){
+			return false;
+		}
+	}
+	DataReceiver* receiver = this->receiver;
+	QMetaObject::invokeMethod(receiver, [receiver, params]() { receiver->updateParamsAndConnect(params); }, Qt::QueuedConnection);
+	return true;
+}
+
+bool StreamClient::open(const QString& ip, quint16 port) {
+	StreamClientParameters params;
+	params.ip = ip;
+	params.port = port;
+	params.useHeaders = true;
+	params.bitDepth = 0;
+	params.sampleFormat = static_cast<int>(SampleFormat::Unsigned);
+	params.samplesPerLine = 0;
+	params.linesPerFrame = 0;
+	params.framesPerBuffer = 0;
+	return this->open(params);
+}
+
+void StreamClient::close() {
+	QMetaObject::invokeMethod(this->receiver, "onDisconnect", Qt::QueuedConnection);
+}
+
+bool StreamClient::isConnected() const {
+	return this->connected.loadAcquire() != 0;
+}
+
+StreamClientStatistics StreamClient::statistics() const {
+	QMutexLocker locker(&this->statisticsMutex);
+	return this->lastStatistics;
+}
+
+void StreamClient::deliverFrame(QSharedPointer<FrameBuffer> frame) {
+	//the callback is called without holding the lock so it can replace itself or close the client
+	this->callbackMutex.lock();
+	FrameCallback callback = this->frameCallback;
+	this->callbackMutex.unlock();
+	if(callback){
+		callback(StreamFrame(frame));
+	}
+}
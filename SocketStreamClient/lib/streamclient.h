@@ -0,0 +1,149 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef STREAMCLIENT_H
+#define STREAMCLIENT_H
+
+#include <functional>
+#include <QString>
+#include <QSharedPointer>
+#include <QThread>
+#include <QMutex>
+#include <QAtomicInt>
+#include "streamclient_global.h"
+
+class DataReceiver;
+class FrameBuffer;
+
+//the library interface only uses these plain structs, the receiver types stay internal
+
+//description of a received buffer, see FrameInfo
+struct StreamFrameInfo {
+	unsigned int bitDepth;
+	int sampleFormat; //0 = unsigned integer, 1 = signed integer, 2 = 32 bit float
+	unsigned int samplesPerLine;
+	unsigned int linesPerFrame;
+	unsigned int framesPerBuffer;
+	quint32 sizeInBytes;
+	bool hasSequenceNumber; //only set by servers that send version 2 headers
+	quint64 sequenceNumber;
+	qint64 senderTimestampUs; //microseconds since the Unix epoch, sender clock
+	qint64 receiveTimestampUs; //approximate: kernel timestamp of the oldest queued data when the buffer start is parsed, or the software clock
+	bool kernelReceiveTimestamp;
+	int checksumState; //0 = no checksum, 1 = valid, 2 = invalid
+	//part of the full frame the buffer contains, see setStreamRequest()
+	unsigned int regionX;
+	unsigned int regionY;
+	unsigned int fullWidth;
+	unsigned int fullHeight;
+	unsigned int sampleStep;
+	unsigned int lineStep;
+	unsigned int frameStep;
+};
+
+struct StreamClientParameters {
+	QString ip;
+	quint16 port;
+	bool useHeaders; //if false the fields below describe the stream
+	int bitDepth;
+	int sampleFormat;
+	int samplesPerLine;
+	int linesPerFrame;
+	int framesPerBuffer;
+};
+
+struct StreamClientStatistics {
+	quint64 framesReceived;
+	quint64 framesLost;
+	quint64 framesReordered;
+	double meanLatencyMs;
+	double minLatencyMs;
+	double maxLatencyMs;
+	double latencyJitterMs; //standard deviation of the latency
+	double arrivalJitterMs; //standard deviation of the interval between received buffers
+	quint64 framesChecked; //buffers with a payload checksum
+	quint64 checksumFailures;
+};
+
+
+//Borrowed view of a received buffer. The memory stays valid as long as at least one StreamFrame refers to it, so copy the StreamFrame to keep the data beyond the callback and call release() when done.
+class SOCKETSTREAMCLIENT_EXPORT StreamFrame
+{
+public:
+	StreamFrame();
+	explicit StreamFrame(QSharedPointer<FrameBuffer> frame);
+
+	bool isValid() const;
+	const uchar* data() const;
+	quint32 sizeInBytes() const;
+	StreamFrameInfo info() const;
+	bool convertTo8bit(uchar* outputData, int outputSize) const;
+	void release();
+
+private:
+	QSharedPointer<FrameBuffer> frame;
+};
+
+
+//GUI-free entry point to receive data from SocketStreamExtension in-process
+//Qt applications must create their QCoreApplication before the first StreamClient. Otherwise the library runs its own one on a background thread while StreamClients exist.
+class SOCKETSTREAMCLIENT_EXPORT StreamClient
+{
+public:
+	typedef std::function<void(const StreamFrame& frame)> FrameCallback;
+
+	StreamClient();
+	~StreamClient();
+
+	//the callback is invoked on the receiver thread, it should return quickly
+	//setFrameCallback(), setStreamRequest(), open(), close(), isConnected() and statistics() may be called from within the callback, the StreamClient must not be destroyed there
+	//a callback that is already running when it is replaced finishes with the old function, the destructor waits for it
+	void setFrameCallback(FrameCallback callback);
+	//pins the receiver thread and sets its priority. cpus: e.g. "2-3" or empty, numaNode: -1 for none, priority: "nice:<-20..19>", "fifo:<1..99>" or empty. Returns false if an argument could not be parsed.
+	bool setReceiverThreadTuning(const QString& cpus, int numaNode, const QString& priority);
+	//asks the server for a region (width or height 0: up to the end of the frame), a decimation and a frame subsample (steps 1..255). The request is sent again after reconnecting. Returns false if an argument is out of range.
+	bool setStreamRequest(int x, int y, int width, int height, int sampleStep, int lineStep, int frameStep);
+	bool open(const StreamClientParameters& params);
+	bool open(const QString& ip, quint16 port);
+	void close();
+	bool isConnected() const;
+	StreamClientStatistics statistics() const;
+
+private:
+	void deliverFrame(QSharedPointer<FrameBuffer> frame);
+
+	QThread receiverThread;
+	DataReceiver* receiver;
+	QMutex callbackMutex;
+	FrameCallback frameCallback;
+	QAtomicInt connected;
+	mutable QMutex statisticsMutex;
+	StreamClientStatistics lastStatistics;
+
+	Q_DISABLE_COPY(StreamClient)
+};
+
+#endif // STREAMCLIENT_H
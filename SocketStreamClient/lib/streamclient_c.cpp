@@ -0,0 +1,171 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "streamclient_c.h"
+#include "streamclient.h"
+#include <limits>
+
+struct ssc_client {
+	StreamClient client;
+};
+
+struct ssc_frame {
+	StreamFrame frame;
+};
+
+
+ssc_client* ssc_client_create(void) {
+	return new ssc_client();
+}
+
+void ssc_client_destroy(ssc_client* client) {
+	delete client;
+}
+
+void ssc_client_set_frame_callback(ssc_client* client, ssc_frame_callback callback, void* user_data) {
+	if(client == nullptr){
+		return;
+	}
+	if(callback == nullptr){
+		client->client.setFrameCallback(StreamClient::FrameCallback());
+		return;
+	}
+	client->client.setFrameCallback([callback, user_data](const StreamFrame& frame) {
+		ssc_frame* handle = new ssc_frame();
+		handle->frame = frame;
+		callback(handle, user_data);
+	});
+}
+
+int ssc_client_set_receiver_thread(ssc_client* client, const char* cpus, int numa_node, const char* priority) {
+	if(client == nullptr){
+		return 0;
+	}
+	return client->client.setReceiverThreadTuning(QString::fromUtf8(cpus), numa_node, QString::fromUtf8(priority)) ? 1 : 0;
+}
+
+int ssc_client_request_region(ssc_client* client, int x, int y, int width, int height, int sample_step, int line_step, int frame_step) {
+	if(client == nullptr){
+		return 0;
+	}
+	return client->client.setStreamRequest(x, y, width, height, sample_step, line_step, frame_step) ? 1 : 0;
+}
+
+int ssc_client_open(ssc_client* client, const ssc_params* params) {
+	if(client == nullptr || params == nullptr || params->ip == nullptr){
+		return 0;
+	}
+	StreamClientParameters clientParams;
+	clientParams.ip = QString::fromUtf8(params->ip);
+	clientParams.port = params->port;
+	clientParams.useHeaders = params->use_headers != 0;
+	clientParams.bitDepth = params->bit_depth;
+	clientParams.sampleFormat = params->sample_format;
+	clientParams.samplesPerLine = params->samples_per_line;
+	clientParams.linesPerFrame = params->lines_per_frame;
+	clientParams.framesPerBuffer = params->frames_per_buffer;
+	return client->client.open(clientParams) ? 1 : 0;
+}
+
+void ssc_client_close(ssc_client* client) {
+	if(client != nullptr){
+		client->client.close();
+	}
+}
+
+int ssc_client_is_connected(const ssc_client* client) {
+	return (client != nullptr && client->client.isConnected()) ? 1 : 0;
+}
+
+void ssc_client_get_statistics(const ssc_client* client, ssc_statistics* statistics) {
+	if(statistics == nullptr){
+		return;
+	}
+	StreamClientStatistics clientStatistics = {};
+	if(client != nullptr){
+		clientStatistics = client->client.statistics();
+	}
+	statistics->frames_received = clientStatistics.framesReceived;
+	statistics->frames_lost = clientStatistics.framesLost;
+	statistics->frames_reordered = clientStatistics.framesReordered;
+	statistics->mean_latency_ms = clientStatistics.meanLatencyMs;
+	statistics->min_latency_ms = clientStatistics.minLatencyMs;
+	statistics->max_latency_ms = clientStatistics.maxLatencyMs;
+	statistics->latency_jitter_ms = clientStatistics.latencyJitterMs;
+	statistics->arrival_jitter_ms = clientStatistics.arrivalJitterMs;
+	statistics->frames_checked = clientStatistics.framesChecked;
+	statistics->checksum_failures = clientStatistics.checksumFailures;
+}
+
+const void* ssc_frame_data(const ssc_frame* frame) {
+	return frame != nullptr ? frame->frame.data() : nullptr;
+}
+
+size_t ssc_frame_size(const ssc_frame* frame) {
+	return frame != nullptr ? frame->frame.sizeInBytes() : 0;
+}
+
+void ssc_frame_get_info(const ssc_frame* frame, ssc_frame_info* info) {
+	if(info == nullptr){
+		return;
+	}
+	StreamFrameInfo frameInfo = {};
+	if(frame != nullptr){
+		frameInfo = frame->frame.info();
+	}
+	info->bit_depth = frameInfo.bitDepth;
+	info->samples_per_line = frameInfo.samplesPerLine;
+	info->lines_per_frame = frameInfo.linesPerFrame;
+	info->frames_per_buffer = frameInfo.framesPerBuffer;
+	info->size_in_bytes = frameInfo.sizeInBytes;
+	info->sample_format = frameInfo.sampleFormat;
+	info->has_sequence_number = frameInfo.hasSequenceNumber ? 1 : 0;
+	info->sequence_number = frameInfo.sequenceNumber;
+	info->sender_timestamp_us = frameInfo.senderTimestampUs;
+	info->receive_timestamp_us = frameInfo.receiveTimestampUs;
+	info->kernel_timestamp = frameInfo.kernelReceiveTimestamp ? 1 : 0;
+	info->checksum_state = frameInfo.checksumState;
+	info->region_x = frameInfo.regionX;
+	info->region_y = frameInfo.regionY;
+	info->full_width = frameInfo.fullWidth;
+	info->full_height = frameInfo.fullHeight;
+	info->sample_step = frameInfo.sampleStep;
+	info->line_step = frameInfo.lineStep;
+	info->frame_step = frameInfo.frameStep;
+}
+
+int ssc_frame_convert_to_8bit(const ssc_frame* frame, unsigned char* output, size_t output_size) {
+	if(frame == nullptr){
+		return 0;
+	}
+	//only needs to hold one byte per sample of a frame, larger buffers are clamped instead of truncated
+	int outputSize = output_size > static_cast<size_t>(std::numeric_limits<int>::max()) ? std::numeric_limits<int>::max() : static_cast<int>(output_size);
+	return frame->frame.convertTo8bit(output, outputSize) ? 1 : 0;
+}
+
+void ssc_frame_release(ssc_frame* frame) {
+	delete frame;
+}
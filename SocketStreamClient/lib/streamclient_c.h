@@ -0,0 +1,134 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef STREAMCLIENT_C_H
+#define STREAMCLIENT_C_H
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#  if defined(SOCKETSTREAMCLIENT_LIBRARY)
+#    define SSC_API __declspec(dllexport)
+#  else
+#    define SSC_API __declspec(dllimport)
+#  endif
+#else
+#  define SSC_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ssc_client ssc_client;
+typedef struct ssc_frame ssc_frame;
+
+/* sample formats, the sample size follows from the bit depth */
+#define SSC_SAMPLE_UNSIGNED 0
+#define SSC_SAMPLE_SIGNED 1
+#define SSC_SAMPLE_FLOAT 2 /* 32 bit IEEE 754 */
+
+/* payload integrity check, only servers that send version 4 headers provide a checksum */
+#define SSC_CHECKSUM_NONE 0
+#define SSC_CHECKSUM_VALID 1
+#define SSC_CHECKSUM_INVALID 2
+
+typedef struct ssc_params {
+	const char* ip;
+	unsigned short port;
+	int use_headers; /* if 0 the fields below describe the stream */
+	int bit_depth;
+	int samples_per_line;
+	int lines_per_frame;
+	int frames_per_buffer;
+	int sample_format;
+} ssc_params;
+
+typedef struct ssc_frame_info {
+	unsigned int bit_depth;
+	unsigned int samples_per_line;
+	unsigned int lines_per_frame;
+	unsigned int frames_per_buffer;
+	unsigned int size_in_bytes;
+	int sample_format;
+	int has_sequence_number; /* only set by servers that send version 2 headers */
+	unsigned long long sequence_number;
+	long long sender_timestamp_us; /* microseconds since the Unix epoch, sender clock */
+	long long receive_timestamp_us; /* approximate, taken when the buffer start is parsed: kernel timestamp of the oldest queued segment if available, otherwise the software clock */
+	int kernel_timestamp; /* 1 if receive_timestamp_us is a kernel timestamp, 0 if the software clock was used */
+	int checksum_state; /* one of SSC_CHECKSUM_*, frames with an invalid checksum are still delivered */
+	/* part of the full frame the buffer contains, see ssc_client_request_region() */
+	unsigned int region_x;
+	unsigned int region_y;
+	unsigned int full_width;
+	unsigned int full_height;
+	unsigned int sample_step;
+	unsigned int line_step;
+	unsigned int frame_step;
+} ssc_frame_info;
+
+typedef struct ssc_statistics {
+	unsigned long long frames_received;
+	unsigned long long frames_lost;
+	unsigned long long frames_reordered;
+	double mean_latency_ms;
+	double min_latency_ms;
+	double max_latency_ms;
+	double latency_jitter_ms; /* standard deviation of the latency */
+	double arrival_jitter_ms; /* standard deviation of the interval between received buffers */
+	unsigned long long frames_checked; /* buffers with a payload checksum */
+	unsigned long long checksum_failures;
+} ssc_statistics;
+
+/* Called on the receiver thread. The callee owns 'frame' and must pass it to ssc_frame_release() once the data is no longer needed.
+   All ssc_client_* functions except ssc_client_destroy() may be called from within the callback. */
+typedef void (*ssc_frame_callback)(ssc_frame* frame, void* user_data);
+
+SSC_API ssc_client* ssc_client_create(void);
+SSC_API void ssc_client_destroy(ssc_client* client);
+SSC_API void ssc_client_set_frame_callback(ssc_client* client, ssc_frame_callback callback, void* user_data);
+/* cpus: e.g. "2-3" or NULL, numa_node: -1 for none, priority: "nice:<-20..19>", "fifo:<1..99>" or NULL. Returns 0 if an argument could not be parsed. */
+SSC_API int ssc_client_set_receiver_thread(ssc_client* client, const char* cpus, int numa_node, const char* priority);
+/* Asks the server to send only a region of the full frame (width or height 0: up to the end of the frame), every sample_step-th sample and line_step-th line of it and every frame_step-th frame of a buffer (steps 1..255). All zero with steps of 1 requests the full frame again. Servers without request support ignore it. Returns 0 if an argument is out of range. */
+SSC_API int ssc_client_request_region(ssc_client* client, int x, int y, int width, int height, int sample_step, int line_step, int frame_step);
+/* Returns 0 if the parameters are invalid: an unknown sample format or, without headers, a bit depth that does not fit the sample format (1..16 or 25..32 bit integers, 32 bit float) or an empty or too large buffer. */
+SSC_API int ssc_client_open(ssc_client* client, const ssc_params* params);
+SSC_API void ssc_client_close(ssc_client* client);
+SSC_API int ssc_client_is_connected(const ssc_client* client);
+SSC_API void ssc_client_get_statistics(const ssc_client* client, ssc_statistics* statistics);
+
+SSC_API const void* ssc_frame_data(const ssc_frame* frame);
+SSC_API size_t ssc_frame_size(const ssc_frame* frame);
+SSC_API void ssc_frame_get_info(const ssc_frame* frame, ssc_frame_info* info);
+/* signed and float samples are normalized to the minimum and maximum of the frame */
+SSC_API int ssc_frame_convert_to_8bit(const ssc_frame* frame, unsigned char* output, size_t output_size);
+SSC_API void ssc_frame_release(ssc_frame* frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STREAMCLIENT_C_H
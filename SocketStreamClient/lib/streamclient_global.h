@@ -0,0 +1,38 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef STREAMCLIENT_GLOBAL_H
+#define STREAMCLIENT_GLOBAL_H
+
+#include <QtCore/qglobal.h>
+
+#if defined(SOCKETSTREAMCLIENT_LIBRARY)
+#  define SOCKETSTREAMCLIENT_EXPORT Q_DECL_EXPORT
+#else
+#  define SOCKETSTREAMCLIENT_EXPORT Q_DECL_IMPORT
+#endif
+
+#endif // STREAMCLIENT_GLOBAL_H
@@ -0,0 +1,251 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "benchmark.h"
+#include "bitdepthconverter.h"
+#include "colormap.h"
+#include "cpufeatures.h"
+#include "crc32c.h"
+#include "spatialfilter.h"
+#include "workerpool.h"
+#include <QElapsedTimer>
+#include <QVector>
+#include <QtMath>
+
+#define BENCHMARK_WIDTH 2048
+#define BENCHMARK_HEIGHT 1024
+#define BENCHMARK_ITERATIONS 50
+#define FILTER_BENCHMARK_SIZE 2048
+#define FILTER_BENCHMARK_ITERATIONS 20
+
+namespace {
+	QVector<uchar> createTestData(int bitDepth, int length) {
+		int bytesPerSample = qCeil(static_cast<double>(bitDepth) / 8.0);
+		QVector<uchar> data(length * bytesPerSample);
+		quint32 state = 12345;
+		for(int i = 0; i < data.size(); i++){
+			state = state * 1664525u + 1013904223u;
+			data[i] = static_cast<uchar>(state >> 24);
+		}
+		return data;
+	}
+
+	void printResult(QTextStream& out, const QString& name, int bitDepth, qint64 elapsedNs, int length) {
+		double msPerFrame = elapsedNs / 1e6 / BENCHMARK_ITERATIONS;
+		double megaSamplesPerSecond = static_cast<double>(length) * BENCHMARK_ITERATIONS / (elapsedNs / 1e9) / 1e6;
+		out << QString("%1 %2 %3 ms/frame %4 MS/s").arg(name, -36).arg(bitDepth, 3).arg(msPerFrame, 9, 'f', 3).arg(megaSamplesPerSecond, 10, 'f', 1) << "\n";
+	}
+}
+
+
+bool Benchmark::isRequested(int argc, char *argv[]) {
+	for(int i = 1; i < argc; i++){
+		if(QString(argv[i]) == "--benchmark"){
+			return true;
+		}
+	}
+	return false;
+}
+
+int Benchmark::run() {
+	QTextStream out(stdout);
+	out << "SocketStreamClient benchmark, frame size " << BENCHMARK_WIDTH << "x" << BENCHMARK_HEIGHT << ", " << BENCHMARK_ITERATIONS << " iterations" << "\n";
+	out << "SSE4.2: " << (CpuFeatures::hasSse42() ? "yes" : "no") << ", AVX2: " << (CpuFeatures::hasAvx2() ? "yes" : "no") << "\n\n";
+	runColorMapBenchmark(out);
+	runSampleFormatBenchmark(out);
+	runChecksumBenchmark(out);
+	runFilterBenchmark(out);
+	return 0;
+}
+
+void Benchmark::runColorMapBenchmark(QTextStream& out) {
+	const int length = BENCHMARK_WIDTH * BENCHMARK_HEIGHT;
+	const int bitDepths[] = {8, 12, 16, 32};
+	QVector<uchar> grayOutput(length);
+	QVector<quint32> argbOutput(length);
+	QElapsedTimer timer;
+
+	out << "Display conversion (raw samples to display pixels)" << "\n";
+	for(int bitDepth : bitDepths){
+		QVector<uchar> input = createTestData(bitDepth, length);
+
+		//previous display path: conversion to an 8 bit grayscale buffer
+		timer.start();
+		for(int i = 0; i < BENCHMARK_ITERATIONS; i++){
+			BitDepthConverter::convertTo8bit(input.constData(), grayOutput.data(), bitDepth, length);
+		}
+		printResult(out, "grayscale 8 bit", bitDepth, timer.nsecsElapsed(), length);
+
+		//grayscale buffer expanded to ARGB32 in a second pass
+		timer.start();
+		for(int i = 0; i < BENCHMARK_ITERATIONS; i++){
+			BitDepthConverter::convertTo8bit(input.constData(), grayOutput.data(), bitDepth, length);
+			for(int j = 0; j < length; j++){
+				argbOutput[j] = 0xFF000000u | (grayOutput[j] * 0x00010101u);
+			}
+		}
+		printResult(out, "grayscale 8 bit + ARGB32 expansion", bitDepth, timer.nsecsElapsed(), length);
+
+		//single pass lookup table
+		QStringList names = ColorMap::names();
+		for(int type = 0; type < names.size(); type++){
+			ColorMap colorMap;
+			colorMap.setType(static_cast<ColorMap::Type>(type));
+			colorMap.apply(input.constData(), argbOutput.data(), bitDepth, length); //builds the table
+			timer.start();
+			for(int i = 0; i < BENCHMARK_ITERATIONS; i++){
+				colorMap.apply(input.constData(), argbOutput.data(), bitDepth, length);
+			}
+			printResult(out, "colormap LUT ARGB32 " + names.at(type).toLower(), bitDepth, timer.nsecsElapsed(), length);
+		}
+		out << "\n";
+	}
+}
+
+void Benchmark::runSampleFormatBenchmark(QTextStream& out) {
+	const int length = BENCHMARK_WIDTH * BENCHMARK_HEIGHT;
+	const SampleFormat formats[] = {SampleFormat::Signed, SampleFormat::Signed, SampleFormat::Float};
+	const int bitDepths[] = {16, 32, 32};
+	const char* names[] = {"signed", "signed", "float"};
+	QVector<quint16> indexOutput(length);
+	QVector<quint32> argbOutput(length);
+	ColorMap colorMap;
+	QElapsedTimer timer;
+
+	out << "Signed and float samples (min-max normalization to 16 bit colormap indices)" << "\n";
+	for(int f = 0; f < 3; f++){
+		QVector<uchar> input = createTestData(bitDepths[f], length);
+		if(formats[f] == SampleFormat::Float){
+			//random bytes would contain NaN and infinity
+			float* samples = reinterpret_cast<float*>(input.data());
+			for(int i = 0; i < length; i++){
+				samples[i] = static_cast<float>(input.at(i * 4)) / 16.0f - 8.0f;
+			}
+		}
+		float minValue = 0.0f;
+		float maxValue = 0.0f;
+
+		timer.start();
+		for(int i = 0; i < BENCHMARK_ITERATIONS; i++){
+			BitDepthConverter::findRange(input.constData(), bitDepths[f], formats[f], length, minValue, maxValue);
+		}
+		printResult(out, QString("%1 min-max").arg(names[f]), bitDepths[f], timer.nsecsElapsed(), length);
+
+		timer.start();
+		for(int i = 0; i < BENCHMARK_ITERATIONS; i++){
+			BitDepthConverter::convertTo16bit(input.constData(), indexOutput.data(), bitDepths[f], formats[f], length, minValue, maxValue);
+		}
+		printResult(out, QString("%1 normalization").arg(names[f]), bitDepths[f], timer.nsecsElapsed(), length);
+
+		timer.start();
+		for(int i = 0; i < BENCHMARK_ITERATIONS; i++){
+			BitDepthConverter::findRange(input.constData(), bitDepths[f], formats[f], length, minValue, maxValue);
+			BitDepthConverter::convertTo16bit(input.constData(), indexOutput.data(), bitDepths[f], formats[f], length, minValue, maxValue);
+			colorMap.apply(indexOutput.constData(), argbOutput.data(), 16, length);
+		}
+		printResult(out, QString("%1 min-max + colormap ARGB32").arg(names[f]), bitDepths[f], timer.nsecsElapsed(), length);
+		out << "\n";
+	}
+}
+
+void Benchmark::runChecksumBenchmark(QTextStream& out) {
+	//one 16 bit frame, compared with the copy from the socket into the frame buffer that the checksum is folded into
+	const int length = BENCHMARK_WIDTH * BENCHMARK_HEIGHT;
+	QVector<uchar> input = createTestData(16, length);
+	QVector<uchar> output(input.size());
+	double megaBytes = input.size() / (1024.0 * 1024.0);
+	quint32 crc = 0;
+	QElapsedTimer timer;
+
+	out << "Payload checksum (CRC-32C, " << (Crc32c::isHardwareAccelerated() ? "SSE4.2" : "software") << "), " << megaBytes << " MB per frame" << "\n";
+	timer.start();
+	for(int i = 0; i < BENCHMARK_ITERATIONS; i++){
+		memcpy(output.data(), input.constData(), static_cast<size_t>(input.size()));
+	}
+	qint64 copyNs = timer.nsecsElapsed();
+	timer.start();
+	for(int i = 0; i < BENCHMARK_ITERATIONS; i++){
+		crc = Crc32c::update(crc, input.constData(), static_cast<size_t>(input.size()));
+	}
+	qint64 crcNs = timer.nsecsElapsed();
+	timer.start();
+	for(int i = 0; i < BENCHMARK_ITERATIONS; i++){
+		memcpy(output.data(), input.constData(), static_cast<size_t>(input.size()));
+		crc = Crc32c::update(crc, output.constData(), static_cast<size_t>(output.size()));
+	}
+	qint64 copyAndCrcNs = timer.nsecsElapsed();
+
+	const char* names[] = {"copy", "crc32c", "copy + crc32c"};
+	const qint64 elapsedNs[] = {copyNs, crcNs, copyAndCrcNs};
+	for(int i = 0; i < 3; i++){
+		double gigaBytesPerSecond = megaBytes * BENCHMARK_ITERATIONS / 1024.0 / (elapsedNs[i] / 1e9);
+		out << QString("%1 %2 ms/frame %3 GB/s").arg(names[i], -36).arg(elapsedNs[i] / 1e6 / BENCHMARK_ITERATIONS, 9, 'f', 3).arg(gigaBytesPerSecond, 8, 'f', 2) << "\n";
+	}
+	out << "(checksum " << QString::number(crc, 16) << ")" << "\n\n";
+}
+
+void Benchmark::runFilterBenchmark(QTextStream& out) {
+	//speckle-like test image: random values on a smooth background
+	const int size = FILTER_BENCHMARK_SIZE;
+	const int length = size * size;
+	QVector<uchar> random = createTestData(8, length);
+	QVector<quint16> input(length);
+	for(int y = 0; y < size; y++){
+		for(int x = 0; x < size; x++){
+			input[y * size + x] = static_cast<quint16>(16384 + 96 * (x % 256) + 64 * random.at(y * size + x));
+		}
+	}
+	QVector<quint16> output(length);
+	QVector<quint32> argbOutput(length);
+	double megaPixels = length / 1e6;
+	ColorMap colorMap;
+	colorMap.prepare(16);
+	WorkerPool singleThread(1);
+	WorkerPool pool;
+	WorkerPool* pools[] = {&singleThread, &pool};
+	QElapsedTimer timer;
+
+	out << "Display filters (" << size << "x" << size << " 16 bit, filter + colormap ARGB32, " << pool.threadCount() << " threads)" << "\n";
+	QStringList names = SpatialFilter::names();
+	for(int type = SpatialFilter::None + 1; type < names.size(); type++){
+		SpatialFilter filter;
+		filter.setType(static_cast<SpatialFilter::Type>(type));
+		for(WorkerPool* workerPool : pools){
+			auto applyColorMap = [&](int firstRow, int rowCount) {
+				colorMap.apply(output.constData() + firstRow * size, argbOutput.data() + firstRow * size, 16, rowCount * size);
+			};
+			filter.apply(input.constData(), output.data(), size, size, *workerPool, applyColorMap); //warm-up, the despeckle filter estimates its noise level here
+			timer.start();
+			for(int i = 0; i < FILTER_BENCHMARK_ITERATIONS; i++){
+				filter.apply(input.constData(), output.data(), size, size, *workerPool, applyColorMap);
+			}
+			double msPerFrame = timer.nsecsElapsed() / 1e6 / FILTER_BENCHMARK_ITERATIONS;
+			QString name = QString("%1, %2 thread(s)").arg(names.at(type).toLower()).arg(workerPool->threadCount());
+			out << QString("%1 %2 ms/frame %3 ms/MP %4 fps").arg(name, -36).arg(msPerFrame, 9, 'f', 3).arg(msPerFrame / megaPixels, 7, 'f', 3).arg(1000.0 / msPerFrame, 8, 'f', 1) << "\n";
+		}
+	}
+	out << "\n";
+}
@@ -25,67 +25,247 @@
 **/
 
 #include "bitdepthconverter.h"
+#include "cpufeatures.h"
+#include <QtMath>
+#include <cstring>
+#include <limits>
 
+#ifdef SSC_X86_SIMD
+#include <immintrin.h>
+#endif
 
-BitDepthConverter::BitDepthConverter(QObject *parent) : QObject(parent)
-{
-	this->output8bitData = nullptr;
-	this->bitDepth = 0;
-	this->length = 0;
-	this->conversionRunning = false;
-}
+namespace {
+	enum class SampleType {
+		UInt8,
+		UInt16,
+		UInt32,
+		Int8,
+		Int16,
+		Int32,
+		Float32,
+		Invalid
+	};
 
-BitDepthConverter::~BitDepthConverter()
-{
-	if(this->output8bitData != nullptr){
-		free(this->output8bitData);
+	SampleType sampleType(int bitDepth, SampleFormat format) {
+		if(bitDepth <= 0 || bitDepth > 32){
+			return SampleType::Invalid;
+		}
+		//17 to 24 bit would need 3 byte samples which none of the kernels read
+		if(bitDepth > 16 && bitDepth <= 24){
+			return SampleType::Invalid;
+		}
+		int bytesPerSample = qCeil(static_cast<double>(bitDepth) / 8.0);
+		switch(format){
+		case SampleFormat::Unsigned:
+			return bytesPerSample == 1 ? SampleType::UInt8 : (bytesPerSample == 2 ? SampleType::UInt16 : SampleType::UInt32);
+		case SampleFormat::Signed:
+			return bytesPerSample == 1 ? SampleType::Int8 : (bytesPerSample == 2 ? SampleType::Int16 : SampleType::Int32);
+		case SampleFormat::Float:
+			return bitDepth == 32 ? SampleType::Float32 : SampleType::Invalid;
+		}
+		return SampleType::Invalid;
 	}
-}
 
-void BitDepthConverter::convertDataTo8bit(void* inputData, int bitDepth, int samplesPerLine, int linesPerFrame) {
-	if(!this->conversionRunning){
-		this->conversionRunning = true;
-		int length = samplesPerLine * linesPerFrame;
-
-		//check if new output8bitData-buffer needs to be created (due to resize or first time use)
-		if(this->output8bitData == nullptr || this->bitDepth != bitDepth || this->length != length){
-			if(bitDepth == 0 || length == 0){
-				emit error(tr("BitDepthConverter: Invalid data dimensions!"));
-				this->conversionRunning = false;
-				return;
+	template<typename T>
+	void findRangeScalar(const T* input, int length, float& minValue, float& maxValue) {
+		for(int i = 0; i < length; i++){
+			float value = static_cast<float>(input[i]);
+			if(value < minValue){
+				minValue = value;
 			}
-			this->bitDepth = bitDepth;
-			this->length = length;
-			if(this->output8bitData != nullptr){
-				free(this->output8bitData);
-				this->output8bitData = nullptr; //assign nullptr to avoid dangling pointer
+			if(value > maxValue){
+				maxValue = value;
 			}
-			this->output8bitData = static_cast<uchar*>(malloc(length*sizeof(uchar)));
 		}
-		//no conversion needed if inputData is already 8bit or below
-		if (bitDepth <= 8){
-			memcpy(this->output8bitData, static_cast<char*>(inputData), length * sizeof(char));
+	}
+
+	template<typename T, typename Out>
+	void normalizeScalar(const T* input, Out* output, int length, float offset, float scale, float outputMax) {
+		for(int i = 0; i < length; i++){
+			float value = (static_cast<float>(input[i]) - offset) * scale;
+			output[i] = static_cast<Out>(qBound(0.0f, value, outputMax) + 0.5f);
 		}
-		//convert to 8 bit element by element
-		else if (bitDepth >= 9 && bitDepth <=16){
-			float factor = 255 / (pow(2,bitDepth) - 1);
-			for(int i=0; i<length; i++){
-				this->output8bitData[i] = static_cast<ushort*>(inputData)[i] * factor;
-				//this->output8bitData[i] = static_cast<uchar*>(inputData)[2*i+1]; //for 16 bit to 8 bit this is also possible
-			}
+	}
+
+#ifdef SSC_X86_SIMD
+	//eight samples of any supported type are widened to float per iteration
+	SSC_TARGET_AVX2 inline __m256 loadAsFloat(const quint8* input) {
+		return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input))));
+	}
+
+	SSC_TARGET_AVX2 inline __m256 loadAsFloat(const qint8* input) {
+		return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input))));
+	}
+
+	SSC_TARGET_AVX2 inline __m256 loadAsFloat(const quint16* input) {
+		return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input))));
+	}
+
+	SSC_TARGET_AVX2 inline __m256 loadAsFloat(const qint16* input) {
+		return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input))));
+	}
+
+	SSC_TARGET_AVX2 inline __m256 loadAsFloat(const quint32* input) {
+		//there is no unsigned conversion in AVX2, the upper and lower 16 bits are converted separately
+		__m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input));
+		__m256 low = _mm256_cvtepi32_ps(_mm256_and_si256(values, _mm256_set1_epi32(0xFFFF)));
+		__m256 high = _mm256_cvtepi32_ps(_mm256_srli_epi32(values, 16));
+		return _mm256_add_ps(_mm256_mul_ps(high, _mm256_set1_ps(65536.0f)), low);
+	}
+
+	SSC_TARGET_AVX2 inline __m256 loadAsFloat(const qint32* input) {
+		return _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input)));
+	}
+
+	SSC_TARGET_AVX2 inline __m256 loadAsFloat(const float* input) {
+		return _mm256_loadu_ps(input);
+	}
+
+	SSC_TARGET_AVX2 inline void storeNormalized(quint8* output, __m256i values) {
+		__m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(values, values), 0x08);
+		__m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_castsi256_si128(words));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(output), bytes);
+	}
+
+	SSC_TARGET_AVX2 inline void storeNormalized(quint16* output, __m256i values) {
+		__m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(values, values), 0x08);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm256_castsi256_si128(words));
+	}
+
+	template<typename T>
+	SSC_TARGET_AVX2 void findRangeAvx2(const T* input, int length, float& minValue, float& maxValue) {
+		//NaN samples are skipped because min/max return the second operand if one of them is NaN
+		__m256 minimum = _mm256_set1_ps(minValue);
+		__m256 maximum = _mm256_set1_ps(maxValue);
+		int i = 0;
+		for(; i + 8 <= length; i += 8){
+			__m256 values = loadAsFloat(input + i);
+			minimum = _mm256_min_ps(values, minimum);
+			maximum = _mm256_max_ps(values, maximum);
 		}
-		else if (bitDepth > 16 && bitDepth <=32){
-			float factor = 255 / (pow(2,bitDepth) - 1);
-			for(int i=0; i<length; i++){
-				this->output8bitData[i] = static_cast<unsigned int*>(inputData)[i] * factor;
-			}
-		//do nothing if bit depth is out of range
-		}else{
+		float minima[8];
+		float maxima[8];
+		_mm256_storeu_ps(minima, minimum);
+		_mm256_storeu_ps(maxima, maximum);
+		findRangeScalar(minima, 8, minValue, maxValue);
+		findRangeScalar(maxima, 8, minValue, maxValue);
+		findRangeScalar(input + i, length - i, minValue, maxValue);
+	}
+
+	template<typename T, typename Out>
+	SSC_TARGET_AVX2 void normalizeAvx2(const T* input, Out* output, int length, float offset, float scale, float outputMax) {
+		const __m256 offsets = _mm256_set1_ps(offset);
+		const __m256 scales = _mm256_set1_ps(scale);
+		const __m256 upperBound = _mm256_set1_ps(outputMax);
+		const __m256 lowerBound = _mm256_setzero_ps();
+		int i = 0;
+		for(; i + 8 <= length; i += 8){
+			__m256 values = _mm256_mul_ps(_mm256_sub_ps(loadAsFloat(input + i), offsets), scales);
+			values = _mm256_max_ps(_mm256_min_ps(values, upperBound), lowerBound);
+			storeNormalized(output + i, _mm256_cvtps_epi32(values));
+		}
+		normalizeScalar(input + i, output + i, length - i, offset, scale, outputMax);
+	}
+#endif
+
+	template<typename T>
+	void findRangeOf(const void* inputData, int length, float& minValue, float& maxValue) {
+		const T* input = static_cast<const T*>(inputData);
+#ifdef SSC_X86_SIMD
+		if(CpuFeatures::hasAvx2()){
+			findRangeAvx2(input, length, minValue, maxValue);
 			return;
 		}
+#endif
+		findRangeScalar(input, length, minValue, maxValue);
+	}
+
+	template<typename T, typename Out>
+	void normalize(const void* inputData, Out* output, int length, float offset, float scale, float outputMax) {
+		const T* input = static_cast<const T*>(inputData);
+#ifdef SSC_X86_SIMD
+		if(CpuFeatures::hasAvx2()){
+			normalizeAvx2(input, output, length, offset, scale, outputMax);
+			return;
+		}
+#endif
+		normalizeScalar(input, output, length, offset, scale, outputMax);
+	}
+
+	template<typename Out>
+	bool convertRange(const void* inputData, Out* outputData, int bitDepth, SampleFormat format, int length, float minValue, float maxValue) {
+		float outputMax = static_cast<float>(std::numeric_limits<Out>::max());
+		float range = maxValue - minValue;
+		float scale = (range > 0.0f && qIsFinite(range)) ? outputMax / range : 0.0f;
+		switch(sampleType(bitDepth, format)){
+		case SampleType::UInt8: normalize<quint8>(inputData, outputData, length, minValue, scale, outputMax); return true;
+		case SampleType::UInt16: normalize<quint16>(inputData, outputData, length, minValue, scale, outputMax); return true;
+		case SampleType::UInt32: normalize<quint32>(inputData, outputData, length, minValue, scale, outputMax); return true;
+		case SampleType::Int8: normalize<qint8>(inputData, outputData, length, minValue, scale, outputMax); return true;
+		case SampleType::Int16: normalize<qint16>(inputData, outputData, length, minValue, scale, outputMax); return true;
+		case SampleType::Int32: normalize<qint32>(inputData, outputData, length, minValue, scale, outputMax); return true;
+		case SampleType::Float32: normalize<float>(inputData, outputData, length, minValue, scale, outputMax); return true;
+		case SampleType::Invalid: break;
+		}
+		return false;
+	}
+}
+
 
-		emit converted8bitData(output8bitData, samplesPerLine, linesPerFrame);
-		free(inputData); //todo:Rethink memory management. Memory for 'inputData' is allocated in 'dataReceiver'.Explore options for allowing 'dataReceiver' to also handle freeing this memory.
-		this->conversionRunning = false;
+bool BitDepthConverter::convertTo8bit(const void* inputData, uchar* outputData, int bitDepth, int length) {
+	//no conversion needed if inputData is already 8bit or below
+	if (bitDepth > 0 && bitDepth <= 8){
+		memcpy(outputData, inputData, length * sizeof(char));
 	}
+	//convert to 8 bit element by element
+	else if (bitDepth >= 9 && bitDepth <=16){
+		float factor = 255 / (pow(2,bitDepth) - 1);
+		const ushort* input = static_cast<const ushort*>(inputData);
+		for(int i=0; i<length; i++){
+			outputData[i] = input[i] * factor;
+		}
+	}
+	else if (bitDepth > 24 && bitDepth <=32){
+		float factor = 255 / (pow(2,bitDepth) - 1);
+		const unsigned int* input = static_cast<const unsigned int*>(inputData);
+		for(int i=0; i<length; i++){
+			outputData[i] = input[i] * factor;
+		}
+	}else{
+		return false;
+	}
+	return true;
+}
+
+bool BitDepthConverter::isSupported(int bitDepth, SampleFormat format) {
+	return sampleType(bitDepth, format) != SampleType::Invalid;
+}
+
+bool BitDepthConverter::findRange(const void* inputData, int bitDepth, SampleFormat format, int length, float& minValue, float& maxValue) {
+	minValue = std::numeric_limits<float>::max();
+	maxValue = -std::numeric_limits<float>::max();
+	switch(sampleType(bitDepth, format)){
+	case SampleType::UInt8: findRangeOf<quint8>(inputData, length, minValue, maxValue); break;
+	case SampleType::UInt16: findRangeOf<quint16>(inputData, length, minValue, maxValue); break;
+	case SampleType::UInt32: findRangeOf<quint32>(inputData, length, minValue, maxValue); break;
+	case SampleType::Int8: findRangeOf<qint8>(inputData, length, minValue, maxValue); break;
+	case SampleType::Int16: findRangeOf<qint16>(inputData, length, minValue, maxValue); break;
+	case SampleType::Int32: findRangeOf<qint32>(inputData, length, minValue, maxValue); break;
+	case SampleType::Float32: findRangeOf<float>(inputData, length, minValue, maxValue); break;
+	case SampleType::Invalid: return false;
+	}
+	if(minValue > maxValue){
+		//no samples or only NaN
+		minValue = 0.0f;
+		maxValue = 0.0f;
+	}
+	return true;
+}
+
+bool BitDepthConverter::convertTo8bit(const void* inputData, uchar* outputData, int bitDepth, SampleFormat format, int length, float minValue, float maxValue) {
+	return convertRange(inputData, outputData, bitDepth, format, length, minValue, maxValue);
+}
+
+bool BitDepthConverter::convertTo16bit(const void* inputData, quint16* outputData, int bitDepth, SampleFormat format, int length, float minValue, float maxValue) {
+	return convertRange(inputData, outputData, bitDepth, format, length, minValue, maxValue);
 }
@@ -27,32 +27,18 @@
 #ifndef BITDEPTHCONVERTER_H
 #define BITDEPTHCONVERTER_H
 
-#include <QObject>
-#include <QSharedPointer>
-#include <QByteArray>
+#include <QtGlobal>
+#include "frame.h"
 
-class BitDepthConverter : public QObject
+class BitDepthConverter
 {
-	Q_OBJECT
 public:
-	explicit BitDepthConverter(QObject *parent = nullptr);
-	~BitDepthConverter();
-
-private:
-	uchar* output8bitData;
-	int bitDepth;
-	int length;
-	bool conversionRunning;
-
-public slots:
-	void convertDataTo8bit(void* inputData, int bitDepth, int samplesPerLine, int linesPerFrame);
-
-signals:
-	void converted8bitData(uchar *output8bitData, unsigned int samplesPerLine, unsigned int linesPerFrame);
-	void info(QString);
-	void error(QString);
-
-
+	static bool convertTo8bit(const void* inputData, uchar* outputData, int bitDepth, int length);
 
+	//signed and float samples (and unsigned samples that should not use the full range) are mapped linearly from [minValue, maxValue] to the output range, values outside are clamped
+	static bool isSupported(int bitDepth, SampleFormat format);
+	static bool findRange(const void* inputData, int bitDepth, SampleFormat format, int length, float& minValue, float& maxValue);
+	static bool convertTo8bit(const void* inputData, uchar* outputData, int bitDepth, SampleFormat format, int length, float minValue, float maxValue);
+	static bool convertTo16bit(const void* inputData, quint16* outputData, int bitDepth, SampleFormat format, int length, float minValue, float maxValue);
 };
 #endif // BITDEPTHCONVERTER_H
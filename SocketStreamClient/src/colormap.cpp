@@ -0,0 +1,220 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "colormap.h"
+#include "cpufeatures.h"
+#include <QtMath>
+
+#ifdef SSC_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#define MAX_TABLE_BITS 16
+
+namespace {
+	struct ColorPoint {
+		double position;
+		int r;
+		int g;
+		int b;
+	};
+
+	//viridis sampled from the matplotlib definition, intermediate values are interpolated linearly
+	const ColorPoint viridisPoints[] = {
+		{0.000,  68,   1,  84},
+		{0.125,  71,  44, 122},
+		{0.250,  59,  81, 139},
+		{0.375,  44, 113, 142},
+		{0.500,  33, 144, 141},
+		{0.625,  39, 173, 129},
+		{0.750,  92, 200,  99},
+		{0.875, 170, 220,  50},
+		{1.000, 253, 231,  37}
+	};
+
+	int toChannel(double value) {
+		return qBound(0, qRound(value * 255.0), 255);
+	}
+
+	quint32 argb(int r, int g, int b) {
+		return 0xFF000000u | (static_cast<quint32>(r) << 16) | (static_cast<quint32>(g) << 8) | static_cast<quint32>(b);
+	}
+
+	template<typename T>
+	void applyTable(const T* input, quint32* output, const quint32* table, int length, int shift, quint32 maxIndex) {
+		for(int i = 0; i < length; i++){
+			quint32 index = static_cast<quint32>(input[i]) >> shift;
+			output[i] = table[index < maxIndex ? index : maxIndex];
+		}
+	}
+
+#ifdef SSC_X86_SIMD
+	//eight table lookups per iteration with AVX2 gather
+	SSC_TARGET_AVX2 void applyTable8Avx2(const quint8* input, quint32* output, const quint32* table, int length, quint32 maxIndex) {
+		const __m256i maxIndices = _mm256_set1_epi32(static_cast<int>(maxIndex));
+		int i = 0;
+		for(; i + 8 <= length; i += 8){
+			__m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input + i)));
+			indices = _mm256_min_epu32(indices, maxIndices);
+			__m256i pixels = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), indices, 4);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), pixels);
+		}
+		applyTable(input + i, output + i, table, length - i, 0, maxIndex);
+	}
+
+	SSC_TARGET_AVX2 void applyTable16Avx2(const quint16* input, quint32* output, const quint32* table, int length, quint32 maxIndex) {
+		const __m256i maxIndices = _mm256_set1_epi32(static_cast<int>(maxIndex));
+		int i = 0;
+		for(; i + 8 <= length; i += 8){
+			__m256i indices = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)));
+			indices = _mm256_min_epu32(indices, maxIndices);
+			__m256i pixels = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), indices, 4);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), pixels);
+		}
+		applyTable(input + i, output + i, table, length - i, 0, maxIndex);
+	}
+
+	SSC_TARGET_AVX2 void applyTable32Avx2(const quint32* input, quint32* output, const quint32* table, int length, int shift, quint32 maxIndex) {
+		const __m256i maxIndices = _mm256_set1_epi32(static_cast<int>(maxIndex));
+		const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+		int i = 0;
+		for(; i + 8 <= length; i += 8){
+			__m256i indices = _mm256_srl_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i)), shiftCount);
+			indices = _mm256_min_epu32(indices, maxIndices);
+			__m256i pixels = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), indices, 4);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), pixels);
+		}
+		applyTable(input + i, output + i, table, length - i, shift, maxIndex);
+	}
+#endif
+}
+
+
+ColorMap::ColorMap()
+{
+	this->currentType = Gray;
+	this->tableBitDepth = 0;
+	this->inputShift = 0;
+	this->table.reserve(1 << MAX_TABLE_BITS); //switching colormaps or bit depths only refills the table
+}
+
+void ColorMap::setType(Type type) {
+	if(this->currentType != type){
+		this->currentType = type;
+		this->tableBitDepth = 0; //table is rebuilt with the next frame
+	}
+}
+
+QStringList ColorMap::names() {
+	return QStringList() << "Gray" << "Hot" << "Jet" << "Viridis";
+}
+
+void ColorMap::prepare(int bitDepth) {
+	if(bitDepth > 0 && bitDepth <= 32 && this->tableBitDepth != bitDepth){
+		this->buildTable(bitDepth);
+	}
+}
+
+bool ColorMap::apply(const void* inputData, quint32* outputData, int bitDepth, int length) {
+	if(bitDepth <= 0 || bitDepth > 32 || (bitDepth > 16 && bitDepth <= 24)){
+		return false;
+	}
+	this->prepare(bitDepth);
+	const quint32* lut = this->table.constData();
+	quint32 maxIndex = static_cast<quint32>(this->table.size() - 1);
+	bool avx2 = CpuFeatures::hasAvx2();
+	Q_UNUSED(avx2)
+
+	if(bitDepth <= 8){
+		const quint8* input = static_cast<const quint8*>(inputData);
+#ifdef SSC_X86_SIMD
+		if(avx2){
+			applyTable8Avx2(input, outputData, lut, length, maxIndex);
+			return true;
+		}
+#endif
+		applyTable(input, outputData, lut, length, 0, maxIndex);
+	}
+	else if(bitDepth <= 16){
+		const quint16* input = static_cast<const quint16*>(inputData);
+#ifdef SSC_X86_SIMD
+		if(avx2){
+			applyTable16Avx2(input, outputData, lut, length, maxIndex);
+			return true;
+		}
+#endif
+		applyTable(input, outputData, lut, length, 0, maxIndex);
+	}
+	else{
+		const quint32* input = static_cast<const quint32*>(inputData);
+#ifdef SSC_X86_SIMD
+		if(avx2){
+			applyTable32Avx2(input, outputData, lut, length, this->inputShift, maxIndex);
+			return true;
+		}
+#endif
+		applyTable(input, outputData, lut, length, this->inputShift, maxIndex);
+	}
+	return true;
+}
+
+void ColorMap::buildTable(int bitDepth) {
+	int tableBits = qMin(bitDepth, MAX_TABLE_BITS);
+	int size = 1 << tableBits;
+	this->inputShift = bitDepth - tableBits;
+	this->table.resize(size);
+	for(int i = 0; i < size; i++){
+		this->table[i] = colorAt(this->currentType, static_cast<double>(i) / (size - 1));
+	}
+	this->tableBitDepth = bitDepth;
+}
+
+quint32 ColorMap::colorAt(Type type, double position) {
+	switch(type){
+	case Hot:
+		return argb(toChannel(3.0 * position), toChannel(3.0 * position - 1.0), toChannel(3.0 * position - 2.0));
+	case Jet:
+		return argb(toChannel(1.5 - qAbs(4.0 * position - 3.0)), toChannel(1.5 - qAbs(4.0 * position - 2.0)), toChannel(1.5 - qAbs(4.0 * position - 1.0)));
+	case Viridis: {
+		const int count = sizeof(viridisPoints) / sizeof(viridisPoints[0]);
+		for(int i = 1; i < count; i++){
+			if(position <= viridisPoints[i].position){
+				const ColorPoint& a = viridisPoints[i-1];
+				const ColorPoint& b = viridisPoints[i];
+				double t = (position - a.position) / (b.position - a.position);
+				return argb(qRound(a.r + t * (b.r - a.r)), qRound(a.g + t * (b.g - a.g)), qRound(a.b + t * (b.b - a.b)));
+			}
+		}
+		const ColorPoint& last = viridisPoints[count-1];
+		return argb(last.r, last.g, last.b);
+	}
+	case Gray:
+	default: {
+		int gray = toChannel(position);
+		return argb(gray, gray, gray);
+	}
+	}
+}
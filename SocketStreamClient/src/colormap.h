@@ -0,0 +1,65 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef COLORMAP_H
+#define COLORMAP_H
+
+#include <QVector>
+#include <QString>
+#include <QStringList>
+
+//ColorMap maps raw samples directly to ARGB32 pixels with a lookup table that is built once per colormap and bit depth. Inputs above 16 bit are reduced to 16 bit table indices by a shift.
+class ColorMap
+{
+public:
+	enum Type {
+		Gray,
+		Hot,
+		Jet,
+		Viridis
+	};
+
+	ColorMap();
+
+	void setType(Type type);
+	Type type() const { return this->currentType; }
+	//builds the table for the given bit depth, apply() with the same bit depth does not modify the ColorMap afterwards and can be called from several threads
+	void prepare(int bitDepth);
+	bool apply(const void* inputData, quint32* outputData, int bitDepth, int length);
+
+	static QStringList names();
+
+private:
+	void buildTable(int bitDepth);
+	static quint32 colorAt(Type type, double position);
+
+	QVector<quint32> table;
+	Type currentType;
+	int tableBitDepth;
+	int inputShift;
+};
+
+#endif // COLORMAP_H
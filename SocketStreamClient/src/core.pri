@@ -0,0 +1,27 @@
+# Receiver, stream parser and converters. Shared by the GUI application and the client library.
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+	$$PWD/bitdepthconverter.cpp \
+	$$PWD/cpufeatures.cpp \
+	$$PWD/crc32c.cpp \
+	$$PWD/datareceiver.cpp \
+	$$PWD/frame.cpp \
+	$$PWD/receivetimestamp.cpp \
+	$$PWD/streamheader.cpp \
+	$$PWD/streamrequest.cpp \
+	$$PWD/streamstatistics.cpp \
+	$$PWD/threadtuning.cpp
+
+HEADERS += \
+	$$PWD/bitdepthconverter.h \
+	$$PWD/cpufeatures.h \
+	$$PWD/crc32c.h \
+	$$PWD/datareceiver.h \
+	$$PWD/frame.h \
+	$$PWD/receivetimestamp.h \
+	$$PWD/streamheader.h \
+	$$PWD/streamrequest.h \
+	$$PWD/streamstatistics.h \
+	$$PWD/threadtuning.h
@@ -0,0 +1,74 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "cpufeatures.h"
+
+#if defined(_MSC_VER) && defined(SSC_X86_SIMD)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+	struct Features {
+		bool sse42;
+		bool avx2;
+	};
+
+	Features detectFeatures() {
+		Features features = {false, false};
+#if defined(__GNUC__) && defined(SSC_X86_SIMD)
+		__builtin_cpu_init();
+		features.sse42 = __builtin_cpu_supports("sse4.2");
+		features.avx2 = __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER) && defined(SSC_X86_SIMD)
+		int registers[4];
+		__cpuid(registers, 0);
+		int maxLeaf = registers[0];
+		__cpuid(registers, 1);
+		features.sse42 = (registers[2] & (1 << 20)) != 0;
+		bool osSavesYmm = (registers[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+		if(maxLeaf >= 7 && osSavesYmm){
+			__cpuidex(registers, 7, 0);
+			features.avx2 = (registers[1] & (1 << 5)) != 0;
+		}
+#endif
+		return features;
+	}
+
+	const Features& features() {
+		static const Features detectedFeatures = detectFeatures();
+		return detectedFeatures;
+	}
+}
+
+
+bool CpuFeatures::hasSse42() {
+	return features().sse42;
+}
+
+bool CpuFeatures::hasAvx2() {
+	return features().avx2;
+}
@@ -0,0 +1,50 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+#include <QtGlobal>
+
+//SIMD kernels are compiled for the baseline architecture and enabled at runtime if the cpu supports them
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define SSC_X86_SIMD
+	#define SSC_TARGET_AVX2 __attribute__((target("avx2")))
+	#define SSC_TARGET_SSE42 __attribute__((target("sse4.2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#define SSC_X86_SIMD
+	#define SSC_TARGET_AVX2
+	#define SSC_TARGET_SSE42
+#endif
+
+class CpuFeatures
+{
+public:
+	static bool hasSse42();
+	static bool hasAvx2();
+};
+
+#endif // CPUFEATURES_H
@@ -0,0 +1,138 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+
+#include "crc32c.h"
+#include "cpufeatures.h"
+#include <cstring>
+
+#ifdef SSC_X86_SIMD
+#include <nmmintrin.h>
+#endif
+
+#define CRC32C_POLYNOMIAL 0x82F63B78 //reversed representation of 0x1EDC6F41
+
+namespace {
+	struct Tables {
+		quint32 values[8][256];
+	};
+
+	Tables createTables() {
+		Tables tables;
+		for(quint32 i = 0; i < 256; i++){
+			quint32 crc = i;
+			for(int bit = 0; bit < 8; bit++){
+				crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLYNOMIAL : crc >> 1;
+			}
+			tables.values[0][i] = crc;
+		}
+		for(quint32 i = 0; i < 256; i++){
+			for(int slice = 1; slice < 8; slice++){
+				quint32 previous = tables.values[slice - 1][i];
+				tables.values[slice][i] = (previous >> 8) ^ tables.values[0][previous & 0xFF];
+			}
+		}
+		return tables;
+	}
+
+	const Tables& tables() {
+		static const Tables crcTables = createTables();
+		return crcTables;
+	}
+
+	quint32 updateSoftware(quint32 crc, const uchar* data, size_t length) {
+		const quint32 (*table)[256] = tables().values;
+		while(length > 0 && (reinterpret_cast<quintptr>(data) & 7) != 0){
+			crc = (crc >> 8) ^ table[0][(crc ^ *data++) & 0xFF];
+			length--;
+		}
+		//slicing-by-8, the words are assembled byte by byte so the result does not depend on the endianness of the host
+		while(length >= 8){
+			quint32 low = crc ^ (static_cast<quint32>(data[0]) | static_cast<quint32>(data[1]) << 8 | static_cast<quint32>(data[2]) << 16 | static_cast<quint32>(data[3]) << 24);
+			crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24]
+					^ table[3][data[4]] ^ table[2][data[5]] ^ table[1][data[6]] ^ table[0][data[7]];
+			data += 8;
+			length -= 8;
+		}
+		while(length > 0){
+			crc = (crc >> 8) ^ table[0][(crc ^ *data++) & 0xFF];
+			length--;
+		}
+		return crc;
+	}
+
+#ifdef SSC_X86_SIMD
+	SSC_TARGET_SSE42 quint32 updateSse42(quint32 crc, const uchar* data, size_t length) {
+		while(length > 0 && (reinterpret_cast<quintptr>(data) & 7) != 0){
+			crc = _mm_crc32_u8(crc, *data++);
+			length--;
+		}
+#if defined(__x86_64__) || defined(_M_X64)
+		quint64 crc64 = crc;
+		while(length >= 8){
+			quint64 word;
+			memcpy(&word, data, sizeof(word));
+			crc64 = _mm_crc32_u64(crc64, word);
+			data += 8;
+			length -= 8;
+		}
+		crc = static_cast<quint32>(crc64);
+#endif
+		while(length >= 4){
+			quint32 word;
+			memcpy(&word, data, sizeof(word));
+			crc = _mm_crc32_u32(crc, word);
+			data += 4;
+			length -= 4;
+		}
+		while(length > 0){
+			crc = _mm_crc32_u8(crc, *data++);
+			length--;
+		}
+		return crc;
+	}
+#endif
+}
+
+
+quint32 Crc32c::update(quint32 crc, const void* data, size_t length) {
+	const uchar* bytes = static_cast<const uchar*>(data);
+	crc = ~crc;
+#ifdef SSC_X86_SIMD
+	if(CpuFeatures::hasSse42()){
+		return ~updateSse42(crc, bytes, length);
+	}
+#endif
+	return ~updateSoftware(crc, bytes, length);
+}
+
+bool Crc32c::isHardwareAccelerated() {
+#ifdef SSC_X86_SIMD
+	return CpuFeatures::hasSse42();
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,44 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <QtGlobal>
+#include <cstddef>
+
+//CRC-32C (Castagnoli polynomial, as used by iSCSI and ext4). Uses the SSE4.2 crc32 instruction if the cpu supports it and a slicing-by-8 table otherwise.
+class Crc32c
+{
+public:
+	//pass the result of the previous call as crc to continue a checksum over several chunks, start with 0
+	static quint32 update(quint32 crc, const void* data, size_t length);
+	static quint32 compute(const void* data, size_t length) { return update(0, data, length); }
+	static bool isHardwareAccelerated();
+};
+
+#endif // CRC32C_H
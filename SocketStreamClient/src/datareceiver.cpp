@@ -25,25 +25,30 @@
 //**/
 
 #include "datareceiver.h"
+#include "receivetimestamp.h"
+#include "crc32c.h"
 #include <QtMath>
-#include <QDataStream>
 #include <QDebug>
 
-const quint32 MAGIC_NUMBER = 299792458; // used as startIdentifier
-const int HEADER_SIZE = 4 + 4 + 2 + 2 + 1; // startIdentifier + bufferSizeInBytes + frameWidth + frameHeight + bitDepth
-const quint32 MAX_ALLOWED_SIZE = 4 * 4096 * 4096 * 8;
-
 DataReceiver::DataReceiver(QObject *parent)
-	: QObject(parent), socket(new QTcpSocket(this)), buffer(), currentFrameSize(0), state(State::AwaitingHeader)
+	: QObject(parent), socket(new QTcpSocket(this)), framePool(FramePool::create(BUFFERS)), statisticsTimer(new QTimer(this)), state(State::AwaitingHeader)
 {
-	connect(socket, &QTcpSocket::readyRead, this, &DataReceiver::readIncomingData);
-	connect(socket, &QTcpSocket::connected, this, [this]() { emit this->connected(true); });
-	connect(socket, &QTcpSocket::disconnected, this, [this]() { emit this->connected(false); });
+	qRegisterMetaType<Frame>("Frame");
+	qRegisterMetaType<FrameInfo>("FrameInfo");
+	qRegisterMetaType<StreamStatistics>("StreamStatistics");
+	qRegisterMetaType<StreamRequest>("StreamRequest");
 
-	frameDataBuffers.resize(BUFFERS);
-	for (int i = 0; i < BUFFERS; ++i) {
-		frameDataBuffers[i].resize(128); // Initial size, adjust as needed
-	}
+	this->socket->setReadBufferSize(RECEIVE_BUFFER_LIMIT);
+	this->statisticsTimer->setInterval(STATISTICS_INTERVAL_MS);
+	connect(this->statisticsTimer, &QTimer::timeout, this, &DataReceiver::publishStatistics);
+
+	connect(socket, &QTcpSocket::readyRead, this, &DataReceiver::readIncomingData);
+	connect(socket, &QTcpSocket::connected, this, &DataReceiver::onConnected);
+	connect(socket, &QTcpSocket::disconnected, this, [this]() {
+		this->statisticsTimer->stop();
+		this->publishStatistics();
+		emit this->connected(false);
+	});
 }
 
 DataReceiver::~DataReceiver() {
@@ -51,80 +56,67 @@ DataReceiver::~DataReceiver() {
 }
 
 void DataReceiver::processBuffer() {
-	if (buffer.size() < static_cast<qint64>(this->bufferSize)) {
-		return; // Wait for more data
-	}
-	
-	// Extract frame data
-	QByteArray frameData = buffer.left(this->bufferSize);
-	buffer = buffer.mid(this->bufferSize);
-	
-	// Allocate and copy data
-	uchar* dataCopy = static_cast<uchar*>(malloc(this->bufferSize));
-	if (dataCopy) {
-		memcpy(dataCopy, frameData.constData(), this->bufferSize);
-		emit dataAvailable(dataCopy, this->params.bitDepth, this->params.samplesPerLine, this->params.linesPerFrame);
-	} else {
-		qWarning() << "Failed to allocate memory for frame data!";
+	while (this->socket->bytesAvailable() > 0) {
+		if (this->currentFrame.isNull()) {
+			if (this->bufferSize <= 0) {
+				this->socket->readAll(); // Nothing to fill, drop data
+				return;
+			}
+			this->markFrameStart();
+			this->currentFrame = this->framePool->acquire(static_cast<quint32>(this->bufferSize));
+			this->bytesWritten = 0;
+			if (this->currentFrame.isNull()) {
+				qWarning() << "Failed to allocate memory for frame data!";
+				return;
+			}
+			this->fillFrameInfo();
+		}
+
+		if (!this->readFrameData()) {
+			return; // Wait for more data
+		}
+		this->finishFrame();
 	}
 }
 
 void DataReceiver::readIncomingData() {
-	while (this->socket->bytesAvailable()) {
-		QByteArray incomingData = this->socket->readAll();
-		buffer.append(incomingData);
-		if(this->params.useHeaders){
-			processBufferWithHeader();
-		} else {
-			processBuffer();
-		}
+	this->socketBufferedBytes.storeRelease(static_cast<int>(this->socket->bytesAvailable()));
+	if(this->params.useHeaders){
+		processBufferWithHeader();
+	} else {
+		processBuffer();
 	}
 }
 
 void DataReceiver::processBufferWithHeader() {
-	QDataStream stream(buffer);
-	stream.setByteOrder(QDataStream::BigEndian);
-
-	while (true) {
+	while (this->socket->bytesAvailable() > 0) {
 		if (state == State::AwaitingHeader) {
-			if (buffer.size() < HEADER_SIZE)
+			if (!this->readHeader())
 				return;
 
-			quint32 startIdentifier;
-			quint32 bufferSizeInBytes;
-			quint16 frameWidth;
-			quint16 frameHeight;
-			quint8 bitDepth;
-
-			QByteArray headerData = buffer.left(HEADER_SIZE);
-			QDataStream headerStream(headerData);
-			headerStream.setByteOrder(QDataStream::BigEndian);
-			headerStream >> startIdentifier >> bufferSizeInBytes >> frameWidth >> frameHeight >> bitDepth;
-
-			if (startIdentifier != MAGIC_NUMBER) {
-				int magicIndex = buffer.indexOf(reinterpret_cast<const char*>(&MAGIC_NUMBER), sizeof(MAGIC_NUMBER));
-				if (magicIndex == -1) {
-					buffer.clear();
-					return;
-				} else {
-					buffer = buffer.mid(magicIndex);
-					continue;
-				}
-			}
+			quint32 bufferSizeInBytes = this->currentHeader.bufferSizeInBytes;
+			quint16 frameWidth = this->currentHeader.frameWidth;
+			quint16 frameHeight = this->currentHeader.frameHeight;
+			quint8 bitDepth = this->currentHeader.bitDepth;
+			SampleFormat sampleFormat = static_cast<SampleFormat>(this->currentHeader.sampleFormat);
 
-			if(!(bufferSizeInBytes > 0 && bufferSizeInBytes < MAX_ALLOWED_SIZE)) {
-				qDebug() << "DataReceiver: Invalid buffer size detected:" << bufferSizeInBytes;
-				qDebug() << "buffer size should be smaller than" << MAX_ALLOWED_SIZE;
-				return;
+			// Frames may only contain a region of the full frame if the server honors a StreamRequest
+			QRect region(this->currentHeader.regionX, this->currentHeader.regionY, (frameWidth - 1) * this->currentHeader.sampleStep + 1, (frameHeight - 1) * this->currentHeader.lineStep + 1);
+			QSize fullSize(this->currentHeader.fullWidth, this->currentHeader.fullHeight);
+			if(region != this->currentRegion || fullSize != this->currentFullSize) {
+				this->currentRegion = region;
+				this->currentFullSize = fullSize;
+				emit regionChanged(region, fullSize);
 			}
 
-			if(this->params.bitDepth != bitDepth || this->params.linesPerFrame != frameHeight || this->params.samplesPerLine != frameWidth || this->currentFrameSize != bufferSizeInBytes) {
+			if(this->params.bitDepth != bitDepth || this->params.sampleFormat != sampleFormat || this->params.linesPerFrame != frameHeight || this->params.samplesPerLine != frameWidth || this->currentFrameSize != bufferSizeInBytes) {
 				int bytesPerSample = qCeil(static_cast<double>(bitDepth) / 8.0);
 				int bytesPerFrame = bytesPerSample * frameWidth * frameHeight;
 
 				ReceiverParameters newParams;
 				newParams.bitDepth = bitDepth;
-				newParams.framesPerBuffer = bufferSizeInBytes/bytesPerFrame;
+				newParams.sampleFormat = sampleFormat;
+				newParams.framesPerBuffer = bytesPerFrame > 0 ? bufferSizeInBytes/bytesPerFrame : 0;
 				newParams.ip = params.ip;
 				newParams.linesPerFrame = frameHeight;
 				newParams.port = params.port;
@@ -134,36 +126,193 @@ void DataReceiver::processBufferWithHeader() {
 
 				emit paramsChanged(newParams);
 			}
-
 			currentFrameSize = bufferSizeInBytes;
-			currentFrameWidth = frameWidth;
-			currentFrameHeight = frameHeight;
-			currentBitDepth = bitDepth;
 
-			buffer = buffer.mid(HEADER_SIZE);
+			this->currentFrame = this->framePool->acquire(bufferSizeInBytes);
+			this->bytesWritten = 0;
+			if (this->currentFrame.isNull()) {
+				qDebug() << "DataReceiver: Failed to allocate memory for frame data!";
+				continue; // Payload will be skipped while searching for the next header
+			}
+			this->fillFrameInfo();
 			state = State::AwaitingFrame;
 		}
 
 		if (state == State::AwaitingFrame) {
-			if (buffer.size() < static_cast<qint64>(this->bufferSize)){
+			if (!this->readFrameData()) {
 				return;
 			}
+			this->finishFrame();
+		}
+	}
+}
 
-			QByteArray frameData = buffer.left(currentFrameSize);
-			buffer = buffer.mid(currentFrameSize);
+bool DataReceiver::readHeader() {
+	if (this->headerBuffer.isEmpty()) {
+		this->markFrameStart();
+	}
 
-			uchar* dataCopy = static_cast<uchar*>(malloc(currentFrameSize));
-			if(dataCopy){
-				memcpy(dataCopy, frameData.constData(), currentFrameSize);
-				//emit dataAvailable(dataCopy, static_cast<unsigned int>(currentBitDepth), static_cast<unsigned int>(currentFrameWidth), static_cast<unsigned int>(currentFrameHeight));
-				emit dataAvailable(dataCopy, static_cast<unsigned int>(this->params.bitDepth), static_cast<unsigned int>(this->params.samplesPerLine), static_cast<unsigned int>(this->params.linesPerFrame));
-			} else{
-				qDebug() << "DataReceiver: Failed to allocate memory for frame data!";
+	while (true) {
+		// Version 2 headers announce their size within the first StreamHeader::SIZE bytes
+		int missingBytes = StreamHeader::sizeOf(this->headerBuffer) - this->headerBuffer.size();
+		while (missingBytes > 0) {
+			QByteArray headerBytes = this->socket->read(missingBytes);
+			if (headerBytes.isEmpty()) {
+				return false;
+			}
+			this->headerBuffer.append(headerBytes);
+			missingBytes = StreamHeader::sizeOf(this->headerBuffer) - this->headerBuffer.size();
+		}
+
+		this->currentHeader.parse(this->headerBuffer);
+		if (!this->currentHeader.hasValidIdentifier()) {
+			int magicIndex = StreamHeader::indexOfMagicNumber(this->headerBuffer, 1);
+			if (magicIndex == -1) {
+				this->headerBuffer = this->headerBuffer.right(3); // Keep bytes that may belong to a split start identifier
+			} else {
+				this->headerBuffer = this->headerBuffer.mid(magicIndex);
 			}
+			continue;
+		}
+
+		if (!this->currentHeader.hasValidSize()) {
+			qDebug() << "DataReceiver: Invalid buffer size detected:" << this->currentHeader.bufferSizeInBytes;
+			qDebug() << "buffer size should be smaller than" << StreamHeader::MAX_ALLOWED_SIZE;
+			this->headerBuffer = this->headerBuffer.mid(1); // Skip this start identifier and search for the next one
+			continue;
+		}
+
+		if (!this->currentHeader.hasValidSampleFormat()) {
+			qDebug() << "DataReceiver: Unsupported sample format" << this->currentHeader.sampleFormat << "with bit depth" << this->currentHeader.bitDepth;
+			this->headerBuffer = this->headerBuffer.mid(1);
+			continue;
+		}
 
-			state = State::AwaitingHeader;
+		// Bytes behind the header (only present after resynchronization) belong to the payload
+		this->headerBuffer.remove(0, this->currentHeader.headerSize);
+		return true;
+	}
+}
+
+bool DataReceiver::readFrameData() {
+	// Read straight from the socket into the pooled frame buffer, no intermediate copies
+	quint32 frameSize = this->currentFrame->size();
+	char* frameData = reinterpret_cast<char*>(this->currentFrame->data());
+	if (!this->headerBuffer.isEmpty() && this->bytesWritten < frameSize) {
+		int leftoverBytes = qMin(this->headerBuffer.size(), static_cast<int>(frameSize - this->bytesWritten));
+		memcpy(frameData + this->bytesWritten, this->headerBuffer.constData(), leftoverBytes);
+		this->appendToChecksum(frameData + this->bytesWritten, static_cast<quint32>(leftoverBytes));
+		this->headerBuffer.remove(0, leftoverBytes);
+		this->bytesWritten += static_cast<quint32>(leftoverBytes);
+	}
+	while (this->bytesWritten < frameSize) {
+		qint64 bytesRead = this->socket->read(frameData + this->bytesWritten, frameSize - this->bytesWritten);
+		if (bytesRead <= 0) {
+			this->reportProgress();
+			return false;
 		}
+		this->appendToChecksum(frameData + this->bytesWritten, static_cast<quint32>(bytesRead));
+		this->bytesWritten += static_cast<quint32>(bytesRead);
+	}
+	return true;
+}
+
+void DataReceiver::appendToChecksum(const char* data, quint32 length) {
+	// Each chunk is checksummed right after the socket copied it into the frame buffer, while it is still in the cache
+	if (this->verifyChecksum) {
+		this->payloadCrc = Crc32c::update(this->payloadCrc, data, length);
+	}
+}
+
+void DataReceiver::fillFrameInfo() {
+	// Filled in as soon as the buffer is acquired so partially received frames can already be interpreted
+	FrameInfo& info = this->currentFrame->info;
+	info.bitDepth = static_cast<unsigned int>(this->params.bitDepth);
+	info.sampleFormat = this->params.sampleFormat;
+	info.samplesPerLine = static_cast<unsigned int>(this->params.samplesPerLine);
+	info.linesPerFrame = static_cast<unsigned int>(this->params.linesPerFrame);
+	info.framesPerBuffer = static_cast<unsigned int>(this->params.framesPerBuffer);
+	info.hasSequenceNumber = this->params.useHeaders && this->currentHeader.isExtended();
+	info.sequenceNumber = info.hasSequenceNumber ? this->currentHeader.sequenceNumber : 0;
+	info.senderTimestampUs = info.hasSequenceNumber ? this->currentHeader.senderTimestampUs : 0;
+	info.receiveTimestampUs = this->frameReceiveTimestampUs;
+	info.kernelReceiveTimestamp = this->frameKernelTimestamp;
+	info.checksumState = ChecksumState::None;
+	bool hasRegion = this->params.useHeaders && this->currentHeader.version >= 5;
+	info.regionX = hasRegion ? this->currentHeader.regionX : 0;
+	info.regionY = hasRegion ? this->currentHeader.regionY : 0;
+	info.fullWidth = hasRegion ? this->currentHeader.fullWidth : info.samplesPerLine;
+	info.fullHeight = hasRegion ? this->currentHeader.fullHeight : info.linesPerFrame;
+	info.sampleStep = hasRegion ? this->currentHeader.sampleStep : 1;
+	info.lineStep = hasRegion ? this->currentHeader.lineStep : 1;
+	info.frameStep = hasRegion ? this->currentHeader.frameStep : 1;
+	this->verifyChecksum = this->params.useHeaders && this->currentHeader.hasPayloadChecksum();
+	this->payloadCrc = 0;
+	this->reportedLines = 0;
+}
+
+void DataReceiver::reportProgress() {
+	if (!this->progressiveMode || this->currentFrame.isNull()) {
+		return;
+	}
+	const FrameInfo& info = this->currentFrame->info;
+	int linesPerFrame = static_cast<int>(info.linesPerFrame);
+	quint32 bytesPerLine = info.samplesPerLine * static_cast<quint32>(qCeil(static_cast<double>(info.bitDepth) / 8.0));
+	if (bytesPerLine == 0 || linesPerFrame == 0) {
+		return;
 	}
+	int completedLines = static_cast<int>(qMin(this->bytesWritten / bytesPerLine, info.linesPerFrame));
+	int minStep = qMax(1, linesPerFrame / PROGRESS_STEPS);
+	if (completedLines <= this->reportedLines || (completedLines < linesPerFrame && completedLines - this->reportedLines < minStep)) {
+		return;
+	}
+	this->reportedLines = completedLines;
+	emit frameProgress(this->currentFrame, completedLines);
+}
+
+void DataReceiver::finishFrame() {
+	if (this->verifyChecksum) {
+		bool valid = this->payloadCrc == this->currentHeader.payloadChecksum;
+		this->currentFrame->info.checksumState = valid ? ChecksumState::Valid : ChecksumState::Invalid;
+		if (!valid) {
+			qDebug() << "DataReceiver: Payload checksum mismatch in buffer" << this->currentFrame->info.sequenceNumber;
+		}
+		this->verifyChecksum = false;
+	}
+	this->statistics.addFrame(this->currentFrame->info);
+
+	emit frameReceived(this->currentFrame);
+	this->currentFrame.clear();
+	this->bytesWritten = 0;
+	state = State::AwaitingHeader;
+}
+
+void DataReceiver::markFrameStart() {
+	// Bytes that QTcpSocket has already read from the kernel carry no timestamp anymore, so the peeked timestamp belongs to the oldest segment that is still queued and may be later than the start of the buffer.
+	// RECEIVE_BUFFER_LIMIT keeps this error small, but the result is only an approximation.
+	this->frameReceiveTimestampUs = 0;
+	if (this->kernelTimestamps) {
+		this->frameReceiveTimestampUs = ReceiveTimestamp::peekKernelTimestampUs(this->socket->socketDescriptor());
+	}
+	this->frameKernelTimestamp = this->frameReceiveTimestampUs != 0;
+	if (!this->frameKernelTimestamp) {
+		this->frameReceiveTimestampUs = ReceiveTimestamp::currentTimeUs();
+	}
+}
+
+void DataReceiver::onConnected() {
+	this->kernelTimestamps = ReceiveTimestamp::enableKernelTimestamps(this->socket->socketDescriptor());
+	this->statistics.reset();
+	this->statisticsTimer->start();
+	if (!this->request.isFullFrame()) {
+		this->socket->write(this->request.toByteArray());
+	}
+	emit connected(true);
+}
+
+void DataReceiver::publishStatistics() {
+	emit statisticsUpdated(this->statistics);
+	this->statistics.resetLatency();
 }
 
 void DataReceiver::updateParams(ReceiverParameters newParams) {
@@ -182,6 +331,11 @@ void DataReceiver::onConnect() {
 	if(this->socket->state() == QTcpSocket::ConnectedState || this->socket->state() == QTcpSocket::ConnectingState){
 		this->socket->abort(); // Ensure previous connections are closed before reconnecting
 	}
+	this->headerBuffer.clear();
+	this->currentFrame.clear();
+	this->bytesWritten = 0;
+	this->currentFrameSize = 0;
+	state = State::AwaitingHeader;
 	socket->connectToHost(this->params.ip, this->params.port);
 }
 
@@ -200,3 +354,18 @@ void DataReceiver::onRemoteStopClicked() {
 void DataReceiver::setUseHeaders(bool enable) {
 	this->params.useHeaders = enable;
 }
+
+void DataReceiver::setProgressiveMode(bool enable) {
+	this->progressiveMode = enable;
+}
+
+void DataReceiver::setStreamRequest(StreamRequest request) {
+	// Servers that do not know the command ignore it and keep sending full buffers, the frame geometry is always taken from the header
+	if (request == this->request) {
+		return;
+	}
+	this->request = request;
+	if (this->socket->state() == QTcpSocket::ConnectedState) {
+		this->socket->write(request.toByteArray());
+	}
+}
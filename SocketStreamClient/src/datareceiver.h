@@ -28,18 +28,29 @@
 #define DATARECEIVER_H
 
 #define BUFFERS 200
+#define RECEIVE_BUFFER_LIMIT 262144 //keeps most of the pending data in the kernel so receive timestamps can be peeked close to the start of a buffer
+#define STATISTICS_INTERVAL_MS 1000
+#define PROGRESS_STEPS 32 //a partially received frame is announced at most this many times
 
 #include <QObject>
 #include <QTcpSocket>
 #include <QByteArray>
-#include <QDataStream>
-#include <QVector>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QAtomicInt>
+#include <QRect>
+#include <QSize>
+#include "frame.h"
+#include "streamheader.h"
+#include "streamrequest.h"
+#include "streamstatistics.h"
 
 
 struct ReceiverParameters {
 	QString ip;
 	qint16 port;
 	int bitDepth;
+	SampleFormat sampleFormat;
 	int samplesPerLine;
 	int linesPerFrame;
 	int framesPerBuffer;
@@ -53,19 +64,34 @@ public:
 	explicit DataReceiver(QObject *parent = nullptr);
 	~DataReceiver();
 
+	QSharedPointer<FramePool> pool() const { return this->framePool; }
+	int bufferedBytes() const { return this->socketBufferedBytes.loadAcquire(); }
+
 private:
 	QTcpSocket* socket;
 	ReceiverParameters params;
-	QVector<QByteArray> frameDataBuffers;
+	QSharedPointer<FramePool> framePool;
+	Frame currentFrame;
 	int bufferSize = 0;
-	int currentIndex = 0;
-	int bytesWritten = 0;
-
-	QByteArray buffer;
-	quint32 currentFrameSize;
-	quint16 currentFrameWidth;
-	quint16 currentFrameHeight;
-	quint8 currentBitDepth;
+	quint32 bytesWritten = 0;
+
+	QByteArray headerBuffer;
+	StreamHeader currentHeader;
+	quint32 currentFrameSize = 0;
+	qint64 frameReceiveTimestampUs = 0;
+	bool frameKernelTimestamp = false;
+	bool kernelTimestamps = false;
+	bool progressiveMode = false;
+	int reportedLines = 0;
+	bool verifyChecksum = false;
+	quint32 payloadCrc = 0;
+	StreamRequest request; // sent again after reconnecting
+	QRect currentRegion;
+	QSize currentFullSize;
+
+	StreamStatistics statistics;
+	QTimer* statisticsTimer;
+	QAtomicInt socketBufferedBytes;
 
 	enum class State {
 		AwaitingHeader,
@@ -74,6 +100,15 @@ private:
 
 	void processBuffer();
 	void processBufferWithHeader();
+	bool readHeader();
+	bool readFrameData();
+	void appendToChecksum(const char* data, quint32 length);
+	void fillFrameInfo();
+	void reportProgress();
+	void finishFrame();
+	void markFrameStart();
+	void onConnected();
+	void publishStatistics();
 
 public slots:
 	void readIncomingData();
@@ -84,11 +119,16 @@ public slots:
 	void onRemoteStartClicked();
 	void onRemoteStopClicked();
 	void setUseHeaders(bool enable);
+	void setProgressiveMode(bool enable);
+	void setStreamRequest(StreamRequest request);
 
 signals:
-	void dataAvailable(uchar* data, unsigned int bitDepth, unsigned int width, unsigned int height);
+	void frameReceived(Frame frame);
+	void frameProgress(Frame frame, int completedLines); //first frame of the buffer is received up to completedLines, the remaining memory is still being written
 	void connected(bool);
+	void statisticsUpdated(StreamStatistics statistics);
 	void paramsChanged(ReceiverParameters params);
+	void regionChanged(QRect region, QSize fullSize); //part of the full frame that is received, in full frame coordinates. Emitted before paramsChanged.
 
 };
 
@@ -0,0 +1,139 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "frame.h"
+#include <QMutexLocker>
+
+
+FrameBuffer::FrameBuffer(quint32 capacity)
+{
+	this->info.bitDepth = 0;
+	this->info.sampleFormat = SampleFormat::Unsigned;
+	this->info.samplesPerLine = 0;
+	this->info.linesPerFrame = 0;
+	this->info.framesPerBuffer = 0;
+	this->info.sizeInBytes = 0;
+	this->info.hasSequenceNumber = false;
+	this->info.sequenceNumber = 0;
+	this->info.senderTimestampUs = 0;
+	this->info.receiveTimestampUs = 0;
+	this->info.kernelReceiveTimestamp = false;
+	this->info.checksumState = ChecksumState::None;
+	this->info.regionX = 0;
+	this->info.regionY = 0;
+	this->info.fullWidth = 0;
+	this->info.fullHeight = 0;
+	this->info.sampleStep = 1;
+	this->info.lineStep = 1;
+	this->info.frameStep = 1;
+	this->capacityInBytes = capacity;
+	this->payload = static_cast<uchar*>(malloc(capacity));
+	if(this->payload == nullptr){
+		this->capacityInBytes = 0;
+	}
+}
+
+FrameBuffer::~FrameBuffer()
+{
+	if(this->payload != nullptr){
+		free(this->payload);
+	}
+}
+
+
+
+QSharedPointer<FramePool> FramePool::create(int maxPooledFrames) {
+	QSharedPointer<FramePool> pool(new FramePool(maxPooledFrames));
+	pool->self = pool;
+	return pool;
+}
+
+FramePool::FramePool(int maxPooledFrames)
+	: maxPooledFrames(maxPooledFrames), liveFrameCount(0)
+{
+}
+
+FramePool::~FramePool()
+{
+	qDeleteAll(this->freeBuffers);
+}
+
+Frame FramePool::acquire(quint32 sizeInBytes) {
+	FrameBuffer* buffer = nullptr;
+	{
+		QMutexLocker locker(&this->mutex);
+		if(!this->freeBuffers.isEmpty()){
+			buffer = this->freeBuffers.takeLast();
+		}
+	}
+
+	//reuse pooled buffer if it is large enough, otherwise replace it
+	if(buffer != nullptr && buffer->capacity() < sizeInBytes){
+		delete buffer;
+		buffer = nullptr;
+	}
+	if(buffer == nullptr){
+		buffer = new FrameBuffer(sizeInBytes);
+		if(buffer->isNull()){
+			delete buffer;
+			return Frame();
+		}
+	}
+	buffer->info.sizeInBytes = sizeInBytes;
+
+	{
+		QMutexLocker locker(&this->mutex);
+		this->liveFrameCount++;
+	}
+	QWeakPointer<FramePool> pool = this->self;
+	return Frame(buffer, [pool](FrameBuffer* buffer) { FramePool::recycle(pool, buffer); });
+}
+
+int FramePool::liveFrames() const {
+	QMutexLocker locker(&this->mutex);
+	return this->liveFrameCount;
+}
+
+int FramePool::pooledFrames() const {
+	QMutexLocker locker(&this->mutex);
+	return this->freeBuffers.size();
+}
+
+void FramePool::recycle(QWeakPointer<FramePool> pool, FrameBuffer* buffer) {
+	//frames may outlive the pool (e.g. when the receiver is deleted while a consumer still holds a frame)
+	QSharedPointer<FramePool> strongPool = pool.toStrongRef();
+	if(strongPool.isNull()){
+		delete buffer;
+		return;
+	}
+	QMutexLocker locker(&strongPool->mutex);
+	strongPool->liveFrameCount--;
+	if(strongPool->freeBuffers.size() < strongPool->maxPooledFrames){
+		strongPool->freeBuffers.append(buffer);
+	}else{
+		delete buffer;
+	}
+}
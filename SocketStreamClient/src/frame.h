@@ -0,0 +1,122 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <QSharedPointer>
+#include <QWeakPointer>
+#include <QMutex>
+#include <QVector>
+#include <QMetaType>
+
+//encoding of a single sample, the number of bytes per sample follows from bitDepth (float samples always have a bit depth of 32)
+enum class SampleFormat : quint8 {
+	Unsigned = 0,
+	Signed = 1,
+	Float = 2
+};
+
+//result of the payload integrity check, None if the sender did not provide a checksum
+enum class ChecksumState : quint8 {
+	None = 0,
+	Valid = 1,
+	Invalid = 2
+};
+
+struct FrameInfo {
+	unsigned int bitDepth;
+	SampleFormat sampleFormat;
+	unsigned int samplesPerLine;
+	unsigned int linesPerFrame;
+	unsigned int framesPerBuffer;
+	quint32 sizeInBytes;
+	bool hasSequenceNumber;
+	quint64 sequenceNumber;
+	qint64 senderTimestampUs;
+	//approximate: taken when the start of the buffer is parsed, either from the oldest segment still queued in the kernel (which may already contain later bytes of the stream) or from the software clock
+	qint64 receiveTimestampUs;
+	bool kernelReceiveTimestamp; //true if receiveTimestampUs is a kernel timestamp, false if the software clock was used
+	ChecksumState checksumState;
+	//part of the full frame the buffer contains if the server honors a StreamRequest, otherwise the full frame with steps of 1
+	unsigned int regionX;
+	unsigned int regionY;
+	unsigned int fullWidth;
+	unsigned int fullHeight;
+	unsigned int sampleStep;
+	unsigned int lineStep;
+	unsigned int frameStep;
+};
+Q_DECLARE_METATYPE(FrameInfo)
+
+//FrameBuffer is filled by DataReceiver directly from the socket. Consumers only borrow it through a Frame handle, it goes back to the FramePool when the last handle is released.
+class FrameBuffer
+{
+public:
+	explicit FrameBuffer(quint32 capacity);
+	~FrameBuffer();
+
+	uchar* data() { return this->payload; }
+	const uchar* constData() const { return this->payload; }
+	quint32 capacity() const { return this->capacityInBytes; }
+	quint32 size() const { return this->info.sizeInBytes; }
+	bool isNull() const { return this->payload == nullptr; }
+
+	FrameInfo info;
+
+private:
+	uchar* payload;
+	quint32 capacityInBytes;
+
+	Q_DISABLE_COPY(FrameBuffer)
+};
+
+typedef QSharedPointer<FrameBuffer> Frame;
+Q_DECLARE_METATYPE(Frame)
+
+
+class FramePool
+{
+public:
+	static QSharedPointer<FramePool> create(int maxPooledFrames);
+	~FramePool();
+
+	Frame acquire(quint32 sizeInBytes);
+	int liveFrames() const;
+	int pooledFrames() const;
+
+private:
+	explicit FramePool(int maxPooledFrames);
+	static void recycle(QWeakPointer<FramePool> pool, FrameBuffer* buffer);
+
+	mutable QMutex mutex;
+	QVector<FrameBuffer*> freeBuffers;
+	QWeakPointer<FramePool> self;
+	int maxPooledFrames;
+	int liveFrameCount;
+};
+
+#endif // FRAME_H
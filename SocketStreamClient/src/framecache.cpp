@@ -0,0 +1,74 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+
+#include "framecache.h"
+
+
+FrameCache::FrameCache(qint64 maxBytes) : usedBytes(0), maxBytes(maxBytes)
+{
+}
+
+bool FrameCache::find(quint64 bufferId, int frameIndex, QImage& image, FrameInfo& info) {
+	for(int i = 0; i < this->entries.size(); i++){
+		const Entry& entry = this->entries.at(i);
+		if(entry.bufferId == bufferId && entry.frameIndex == frameIndex){
+			image = entry.image;
+			info = entry.info;
+			this->entries.move(i, 0);
+			return true;
+		}
+	}
+	return false;
+}
+
+void FrameCache::insert(quint64 bufferId, int frameIndex, const QImage& image, const FrameInfo& info) {
+	qint64 size = sizeOf(image);
+	if(size > this->maxBytes){
+		return;
+	}
+	//evict least recently used entries until the new one fits
+	while(!this->entries.isEmpty() && this->usedBytes + size > this->maxBytes){
+		this->usedBytes -= sizeOf(this->entries.last().image);
+		this->entries.removeLast();
+	}
+	Entry entry;
+	entry.bufferId = bufferId;
+	entry.frameIndex = frameIndex;
+	entry.image = image;
+	entry.info = info;
+	this->entries.prepend(entry);
+	this->usedBytes += size;
+}
+
+void FrameCache::clear() {
+	this->entries.clear();
+	this->usedBytes = 0;
+}
+
+qint64 FrameCache::sizeOf(const QImage& image) {
+	return static_cast<qint64>(image.bytesPerLine()) * image.height();
+}
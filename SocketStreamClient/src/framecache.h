@@ -0,0 +1,64 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#define FRAME_CACHE_BYTES (256 * 1024 * 1024)
+
+#include <QImage>
+#include <QList>
+#include "frame.h"
+
+//Memory-bounded LRU cache of rendered frames, used while scrubbing through held buffers. An entry is identified by the buffer it was taken from and the index of the frame within that buffer. Only a few hundred entries fit into the memory limit, so a list in recently used order is sufficient.
+class FrameCache
+{
+public:
+	explicit FrameCache(qint64 maxBytes = FRAME_CACHE_BYTES);
+
+	bool find(quint64 bufferId, int frameIndex, QImage& image, FrameInfo& info);
+	void insert(quint64 bufferId, int frameIndex, const QImage& image, const FrameInfo& info);
+	void clear();
+	int count() const { return this->entries.size(); }
+	qint64 sizeInBytes() const { return this->usedBytes; }
+
+private:
+	struct Entry {
+		quint64 bufferId;
+		int frameIndex;
+		QImage image;
+		FrameInfo info;
+	};
+
+	static qint64 sizeOf(const QImage& image);
+
+	QList<Entry> entries; //most recently used first
+	qint64 usedBytes;
+	qint64 maxBytes;
+};
+
+#endif // FRAMECACHE_H
@@ -0,0 +1,514 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "framerenderer.h"
+#include "bitdepthconverter.h"
+#include <QMutexLocker>
+#include <QtMath>
+
+
+FrameRenderer::FrameRenderer(QObject *parent) : QObject(parent)
+{
+	this->renderScheduled = false;
+	this->imageAvailable = false;
+	this->readyInfo = FrameInfo();
+	this->pendingLines = -1;
+	this->progressive = false;
+	this->progressBuffer = nullptr;
+	this->progressSequenceNumber = 0;
+	this->progressCompleted = false;
+	this->renderedLines = 0;
+	this->bandRangeValid = false;
+	this->bandRangeBitDepth = 0;
+	this->bandRangeFormat = SampleFormat::Unsigned;
+	this->bandRangeMin = 0.0f;
+	this->bandRangeMax = 0.0f;
+	this->rangeMode = DefaultRange;
+	this->windowMin = 0.0f;
+	this->windowMax = 1.0f;
+	this->rangeMin = 0.0f;
+	this->rangeMax = 0.0f;
+	this->historyBytes = 0;
+	this->nextBufferId = 0;
+	this->historyEnabled = false;
+	this->holding = false;
+	this->pendingScrubBuffer = 0;
+	this->pendingScrubFrame = 0;
+	this->scrubScheduled = false;
+	this->selectedFrame = 0;
+	this->scrubBuffer = 0;
+	this->scrubFrame = 0;
+	this->lastFramesPerBuffer = 0;
+	this->workerPool = nullptr;
+}
+
+FrameRenderer::~FrameRenderer()
+{
+	delete this->workerPool;
+}
+
+void FrameRenderer::enqueueFrame(Frame frame, int availableLines) {
+	//may be called from any thread, availableLines is -1 for completely received frames
+	if(availableLines < 0){
+		this->receivedFrames.fetchAndAddRelaxed(1);
+	}
+	QMutexLocker locker(&this->mutex);
+	//the history only holds references, buffers are converted when a frame of them is selected
+	if(this->historyEnabled && !this->holding && availableLines < 0){
+		HeldBuffer buffer;
+		buffer.frame = frame;
+		buffer.id = this->nextBufferId++;
+		this->history.append(buffer);
+		this->historyBytes += frame->size();
+		while(this->history.size() > SCRUB_HISTORY_BUFFERS || (this->history.size() > 1 && this->historyBytes > SCRUB_HISTORY_BYTES)){
+			this->historyBytes -= this->history.first().frame->size();
+			this->history.removeFirst();
+		}
+	}
+	this->pendingFrame = frame;
+	this->pendingLines = availableLines;
+	if(!this->renderScheduled){
+		this->renderScheduled = true;
+		QMetaObject::invokeMethod(this, "renderPendingFrame", Qt::QueuedConnection);
+	}
+}
+
+bool FrameRenderer::takeImage(QImage& image, FrameInfo& info) {
+	//the caller's image is handed back to the renderer so its memory can be reused
+	QMutexLocker locker(&this->mutex);
+	if(!this->imageAvailable){
+		return false;
+	}
+	image.swap(this->readyImage);
+	info = this->readyInfo;
+	this->imageAvailable = false;
+	return true;
+}
+
+bool FrameRenderer::takeBands(QList<ImageBand>& bands) {
+	QMutexLocker locker(&this->mutex);
+	if(this->readyBands.isEmpty()){
+		return false;
+	}
+	bands.swap(this->readyBands);
+	this->readyBands.clear();
+	return true;
+}
+
+int FrameRenderer::takeReceivedFrameCount() {
+	return this->receivedFrames.fetchAndStoreRelaxed(0);
+}
+
+void FrameRenderer::scrubTo(int bufferAge, int frameIndex) {
+	//may be called from any thread, requests that arrive while a frame is rendered replace each other
+	QMutexLocker locker(&this->mutex);
+	this->pendingScrubBuffer = bufferAge;
+	this->pendingScrubFrame = frameIndex;
+	if(!this->scrubScheduled){
+		this->scrubScheduled = true;
+		QMetaObject::invokeMethod(this, "renderScrubRequest", Qt::QueuedConnection);
+	}
+}
+
+void FrameRenderer::setWorkerThreadTuning(const ThreadTuning& tuning) {
+	this->workerTuning = tuning;
+	if(this->workerPool != nullptr){
+		this->workerPool->setThreadTuning(tuning);
+	}
+}
+
+void FrameRenderer::renderPendingFrame() {
+	Frame frame;
+	int availableLines;
+	{
+		QMutexLocker locker(&this->mutex);
+		frame.swap(this->pendingFrame);
+		availableLines = this->pendingLines;
+		this->renderScheduled = false;
+	}
+	if(frame.isNull() || this->holding){
+		return;
+	}
+	int framesPerBuffer = static_cast<int>(frame->info.framesPerBuffer);
+	if(framesPerBuffer != this->lastFramesPerBuffer){
+		this->lastFramesPerBuffer = framesPerBuffer;
+		emit scrubRangeChanged(0, framesPerBuffer);
+	}
+	//only the first frame of a buffer is announced while it is being received, filters need the complete frame
+	int frameIndex = qBound(0, this->selectedFrame, qMax(1, framesPerBuffer) - 1);
+	if(this->progressive && frameIndex == 0 && this->filter.type() == SpatialFilter::None){
+		this->renderBand(frame, availableLines);
+		return;
+	}
+	if(availableLines >= 0 || !this->renderFrame(frame, frameIndex)){
+		return;
+	}
+
+	QMutexLocker locker(&this->mutex);
+	this->readyImage.swap(this->workImage);
+	this->readyInfo = frame->info;
+	this->imageAvailable = true;
+}
+
+void FrameRenderer::renderScrubRequest() {
+	int bufferAge;
+	int frameIndex;
+	{
+		QMutexLocker locker(&this->mutex);
+		bufferAge = this->pendingScrubBuffer;
+		frameIndex = this->pendingScrubFrame;
+		this->scrubScheduled = false;
+	}
+	if(!this->holding || this->heldBuffers.isEmpty()){
+		return;
+	}
+	bufferAge = qBound(0, bufferAge, this->heldBuffers.size() - 1);
+	const HeldBuffer& buffer = this->heldBuffers.at(this->heldBuffers.size() - 1 - bufferAge);
+	int framesPerBuffer = qMax(1, static_cast<int>(buffer.frame->info.framesPerBuffer));
+	if(bufferAge != this->scrubBuffer){
+		emit scrubRangeChanged(this->heldBuffers.size(), framesPerBuffer);
+	}
+	this->scrubBuffer = bufferAge;
+	this->scrubFrame = qBound(0, frameIndex, framesPerBuffer - 1);
+	this->showHeldFrame();
+}
+
+void FrameRenderer::showHeldFrame() {
+	const HeldBuffer& buffer = this->heldBuffers.at(this->heldBuffers.size() - 1 - this->scrubBuffer);
+	QImage image;
+	FrameInfo info;
+	if(!this->frameCache.find(buffer.id, this->scrubFrame, image, info)){
+		image = QImage(static_cast<int>(buffer.frame->info.samplesPerLine), static_cast<int>(buffer.frame->info.linesPerFrame), QImage::Format_RGB32);
+		if(image.isNull()){
+			emit error(tr("FrameRenderer: Could not allocate image!"));
+			return;
+		}
+		if(!this->renderLines(buffer.frame, this->scrubFrame, image, 0, image.height())){
+			return;
+		}
+		info = buffer.frame->info;
+		this->frameCache.insert(buffer.id, this->scrubFrame, image, info);
+	}
+
+	//the image stays shared with the cache, it is never written to again
+	QMutexLocker locker(&this->mutex);
+	this->readyImage = image;
+	this->readyInfo = info;
+	this->imageAvailable = true;
+}
+
+void FrameRenderer::clearHistory() {
+	QList<HeldBuffer> releasedBuffers;
+	{
+		QMutexLocker locker(&this->mutex);
+		releasedBuffers.swap(this->history);
+		this->historyBytes = 0;
+	}
+	this->heldBuffers.clear();
+	this->frameCache.clear();
+}
+
+void FrameRenderer::setColorMap(int type) {
+	this->colorMap.setType(static_cast<ColorMap::Type>(type));
+	this->frameCache.clear();
+	if(this->holding && !this->heldBuffers.isEmpty()){
+		this->showHeldFrame();
+	}
+}
+
+void FrameRenderer::setValueRange(int mode, double minValue, double maxValue) {
+	this->rangeMode = static_cast<RangeMode>(mode);
+	this->windowMin = static_cast<float>(minValue);
+	this->windowMax = static_cast<float>(maxValue);
+	this->bandRangeValid = false;
+	this->frameCache.clear();
+	if(this->holding && !this->heldBuffers.isEmpty()){
+		this->showHeldFrame();
+	}
+}
+
+void FrameRenderer::setFilter(int type) {
+	this->filter.setType(static_cast<SpatialFilter::Type>(type));
+	this->frameCache.clear();
+	if(this->holding && !this->heldBuffers.isEmpty()){
+		this->showHeldFrame();
+	}
+}
+
+void FrameRenderer::setHistoryEnabled(bool enable) {
+	//without history no buffer is kept back from the pool and nothing is cached
+	if(!enable){
+		this->setHold(false);
+		this->clearHistory();
+		this->selectedFrame = 0;
+	}
+	QMutexLocker locker(&this->mutex);
+	this->historyEnabled = enable;
+}
+
+void FrameRenderer::setSelectedFrame(int frameIndex) {
+	this->selectedFrame = qMax(0, frameIndex);
+}
+
+void FrameRenderer::setHold(bool enable) {
+	if(enable == this->holding){
+		return;
+	}
+	{
+		QMutexLocker locker(&this->mutex);
+		this->holding = enable;
+		if(enable){
+			this->heldBuffers = this->history;
+		}
+	}
+	if(!enable){
+		this->heldBuffers.clear();
+		this->frameCache.clear();
+		emit scrubRangeChanged(0, this->lastFramesPerBuffer);
+		return;
+	}
+	if(this->heldBuffers.isEmpty()){
+		emit scrubRangeChanged(0, this->lastFramesPerBuffer);
+		return;
+	}
+	//start with the frame that was displayed live
+	this->scrubBuffer = 0;
+	const Frame& newest = this->heldBuffers.last().frame;
+	int framesPerBuffer = qMax(1, static_cast<int>(newest->info.framesPerBuffer));
+	this->scrubFrame = qBound(0, this->selectedFrame, framesPerBuffer - 1);
+	emit scrubRangeChanged(this->heldBuffers.size(), framesPerBuffer);
+	this->showHeldFrame();
+}
+
+void FrameRenderer::setProgressive(bool enable) {
+	this->progressive = enable;
+	this->progressBuffer = nullptr;
+	this->progressCompleted = false;
+	this->renderedLines = 0;
+	this->bandRangeValid = false;
+	QMutexLocker locker(&this->mutex);
+	this->readyBands.clear();
+}
+
+void FrameRenderer::renderBand(const Frame& frame, int availableLines) {
+	int linesPerFrame = static_cast<int>(frame->info.linesPerFrame);
+	int lines = availableLines < 0 ? linesPerFrame : qMin(availableLines, linesPerFrame);
+	//the complete buffer is enqueued once more after its first frame has been reported complete, all bands of it are already rendered
+	bool sameFrame = frame.data() == this->progressBuffer && frame->info.sequenceNumber == this->progressSequenceNumber;
+	if(sameFrame && this->progressCompleted && availableLines < 0){
+		return;
+	}
+	//a completed buffer that is reported again has been reused by the pool for the next frame
+	if(!sameFrame || this->progressCompleted){
+		this->progressBuffer = frame.data();
+		this->progressSequenceNumber = frame->info.sequenceNumber;
+		this->progressCompleted = false;
+		this->renderedLines = 0;
+	}
+	if(lines <= this->renderedLines){
+		return;
+	}
+
+	ImageBand band;
+	band.image = QImage(static_cast<int>(frame->info.samplesPerLine), lines - this->renderedLines, QImage::Format_RGB32);
+	if(band.image.isNull()){
+		emit error(tr("FrameRenderer: Could not allocate image!"));
+		return;
+	}
+	//all bands of a frame use the same range, otherwise the colors would change within the frame. The first band uses the range of the previous complete frame if there is one with the same sample format.
+	bool keepRange = this->renderedLines > 0 || (this->bandRangeValid && this->bandRangeBitDepth == frame->info.bitDepth && this->bandRangeFormat == frame->info.sampleFormat);
+	if(keepRange){
+		this->rangeMin = this->bandRangeMin;
+		this->rangeMax = this->bandRangeMax;
+	}
+	if(!this->renderLines(frame, 0, band.image, this->renderedLines, lines - this->renderedLines, keepRange)){
+		return;
+	}
+	bool wholeFrameRange = !keepRange && lines == linesPerFrame; //a single band of the complete frame was just normalized with its own range
+	this->bandRangeMin = this->rangeMin;
+	this->bandRangeMax = this->rangeMax;
+	band.firstLine = this->renderedLines;
+	band.frameWidth = static_cast<int>(frame->info.samplesPerLine);
+	band.frameHeight = linesPerFrame;
+	band.info = frame->info;
+	this->renderedLines = lines;
+	if(lines == linesPerFrame){
+		//the range of the complete frame is used for all bands of the next frame
+		bool normalized = frame->info.sampleFormat != SampleFormat::Unsigned || this->rangeMode != DefaultRange;
+		this->bandRangeValid = normalized && (wholeFrameRange || this->updateRange(frame, frame->constData(), linesPerFrame, false));
+		this->bandRangeMin = this->rangeMin;
+		this->bandRangeMax = this->rangeMax;
+		this->bandRangeBitDepth = frame->info.bitDepth;
+		this->bandRangeFormat = frame->info.sampleFormat;
+		this->progressCompleted = true;
+	}
+
+	QMutexLocker locker(&this->mutex);
+	if(this->readyBands.size() >= MAX_PENDING_BANDS){
+		this->readyBands.removeFirst();
+	}
+	this->readyBands.append(band);
+}
+
+bool FrameRenderer::prepareImage(int width, int height) {
+	//reuse the image memory unless the image is still shared with the GUI thread
+	if(this->workImage.isDetached() && this->workImage.width() == width && this->workImage.height() == height){
+		return true;
+	}
+	this->workImage = QImage(width, height, QImage::Format_RGB32);
+	return !this->workImage.isNull();
+}
+
+bool FrameRenderer::renderFrame(const Frame& frame, int frameIndex) {
+	if(!this->prepareImage(static_cast<int>(frame->info.samplesPerLine), static_cast<int>(frame->info.linesPerFrame))){
+		emit error(tr("FrameRenderer: Could not allocate image!"));
+		return false;
+	}
+	return this->renderLines(frame, frameIndex, this->workImage, 0, static_cast<int>(frame->info.linesPerFrame));
+}
+
+bool FrameRenderer::renderLines(const Frame& frame, int frameIndex, QImage& image, int firstLine, int lineCount, bool keepRange) {
+	int bitDepth = static_cast<int>(frame->info.bitDepth);
+	int samplesPerLine = static_cast<int>(frame->info.samplesPerLine);
+	int linesPerFrame = static_cast<int>(frame->info.linesPerFrame);
+	int bytesPerSample = qCeil(static_cast<double>(bitDepth) / 8.0);
+	if(bitDepth == 0 || samplesPerLine == 0 || linesPerFrame == 0 || image.width() != samplesPerLine || image.height() < lineCount){
+		emit error(tr("FrameRenderer: Invalid data dimensions!"));
+		return false;
+	}
+	//make sure the requested lines of the selected frame have actually been received
+	qint64 frameOffset = static_cast<qint64>(frameIndex) * samplesPerLine * linesPerFrame * bytesPerSample;
+	if(frame->size() < frameOffset + static_cast<qint64>(samplesPerLine) * (firstLine + lineCount) * bytesPerSample){
+		emit error(tr("FrameRenderer: Received buffer is smaller than one frame!"));
+		return false;
+	}
+
+	//raw samples are mapped to opaque ARGB32 pixels, which is the same memory layout as Format_RGB32
+	const uchar* input = frame->constData() + frameOffset + firstLine * samplesPerLine * bytesPerSample;
+	SampleFormat format = frame->info.sampleFormat;
+	if(this->filter.type() != SpatialFilter::None && firstLine == 0 && lineCount == linesPerFrame){
+		return this->renderFilteredFrame(frame, input, image);
+	}
+	if(format == SampleFormat::Unsigned && this->rangeMode == DefaultRange){
+		for(int y = 0; y < lineCount; y++){
+			quint32* outputLine = reinterpret_cast<quint32*>(image.scanLine(y));
+			if(!this->colorMap.apply(input + y * samplesPerLine * bytesPerSample, outputLine, bitDepth, samplesPerLine)){
+				emit error(tr("FrameRenderer: Bit depth out of range!"));
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//all other samples are normalized to 16 bit colormap indices line by line
+	if(!this->updateRange(frame, input, lineCount, keepRange)){
+		emit error(tr("FrameRenderer: Unsupported sample format!"));
+		return false;
+	}
+	this->lineBuffer.resize(samplesPerLine);
+	for(int y = 0; y < lineCount; y++){
+		quint32* outputLine = reinterpret_cast<quint32*>(image.scanLine(y));
+		BitDepthConverter::convertTo16bit(input + y * samplesPerLine * bytesPerSample, this->lineBuffer.data(), bitDepth, format, samplesPerLine, this->rangeMin, this->rangeMax);
+		this->colorMap.apply(this->lineBuffer.constData(), outputLine, 16, samplesPerLine);
+	}
+	return true;
+}
+
+bool FrameRenderer::renderFilteredFrame(const Frame& frame, const uchar* input, QImage& image) {
+	int bitDepth = static_cast<int>(frame->info.bitDepth);
+	int width = static_cast<int>(frame->info.samplesPerLine);
+	int height = static_cast<int>(frame->info.linesPerFrame);
+	int bytesPerSample = qCeil(static_cast<double>(bitDepth) / 8.0);
+	SampleFormat format = frame->info.sampleFormat;
+	if(format == SampleFormat::Unsigned && this->rangeMode == DefaultRange){
+		if(!BitDepthConverter::isSupported(bitDepth, format)){
+			emit error(tr("FrameRenderer: Bit depth out of range!"));
+			return false;
+		}
+		this->rangeMin = 0.0f;
+		this->rangeMax = static_cast<float>(qPow(2.0, bitDepth) - 1.0);
+	}else if(!this->updateRange(frame, input, height, false)){
+		emit error(tr("FrameRenderer: Unsupported sample format!"));
+		return false;
+	}
+	if(this->workerPool == nullptr){
+		this->workerPool = new WorkerPool();
+		this->workerPool->setThreadTuning(this->workerTuning);
+	}
+	int length = width * height;
+	if(this->filterInput.size() != length){
+		this->filterInput.resize(length);
+		this->filterOutput.resize(length);
+	}
+
+	//the filters work on normalized 16 bit values, so the kernels do not depend on the sample format
+	quint16* normalized = this->filterInput.data();
+	float minValue = this->rangeMin;
+	float maxValue = this->rangeMax;
+	int tileCount = (height + FILTER_TILE_ROWS - 1) / FILTER_TILE_ROWS;
+	this->workerPool->run(tileCount, [=](int tile) {
+		int firstRow = tile * FILTER_TILE_ROWS;
+		int rows = qMin(FILTER_TILE_ROWS, height - firstRow);
+		BitDepthConverter::convertTo16bit(input + static_cast<qint64>(firstRow) * width * bytesPerSample, normalized + firstRow * width, bitDepth, format, rows * width, minValue, maxValue);
+	});
+
+	//scanLine() must not be called concurrently, rows are addressed through the image bits instead
+	this->colorMap.prepare(16);
+	ColorMap* colorMap = &this->colorMap;
+	const quint16* filtered = this->filterOutput.constData();
+	uchar* bits = image.bits();
+	int bytesPerLine = image.bytesPerLine();
+	this->filter.apply(this->filterInput.constData(), this->filterOutput.data(), width, height, *this->workerPool, [=](int firstRow, int rowCount) {
+		for(int y = firstRow; y < firstRow + rowCount; y++){
+			colorMap->apply(filtered + y * width, reinterpret_cast<quint32*>(bits + y * bytesPerLine), 16, width);
+		}
+	});
+	return true;
+}
+
+bool FrameRenderer::updateRange(const Frame& frame, const uchar* input, int lineCount, bool keepRange) {
+	int bitDepth = static_cast<int>(frame->info.bitDepth);
+	int samplesPerLine = static_cast<int>(frame->info.samplesPerLine);
+	if(!BitDepthConverter::isSupported(bitDepth, frame->info.sampleFormat)){
+		return false;
+	}
+	if(this->rangeMode == WindowRange){
+		this->rangeMin = this->windowMin;
+		this->rangeMax = this->windowMax;
+		return true;
+	}
+	if(keepRange){
+		return true;
+	}
+	float minValue = 0.0f;
+	float maxValue = 0.0f;
+	if(!BitDepthConverter::findRange(input, bitDepth, frame->info.sampleFormat, samplesPerLine * lineCount, minValue, maxValue)){
+		return false;
+	}
+	this->rangeMin = minValue;
+	this->rangeMax = maxValue;
+	return true;
+}
@@ -0,0 +1,167 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef FRAMERENDERER_H
+#define FRAMERENDERER_H
+
+#include <QObject>
+#include <QImage>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QVector>
+#include <QList>
+#include "frame.h"
+#include "colormap.h"
+#include "framecache.h"
+#include "spatialfilter.h"
+#include "workerpool.h"
+#include "threadtuning.h"
+
+#define MAX_PENDING_BANDS 64
+#define SCRUB_HISTORY_BUFFERS 8 //received buffers that are kept for scrubbing
+#define SCRUB_HISTORY_BYTES (512 * 1024 * 1024)
+
+//rows of a partially received frame that are ready to be copied into the displayed image
+struct ImageBand {
+	QImage image;
+	int firstLine;
+	int frameWidth;
+	int frameHeight;
+	FrameInfo info;
+};
+
+//buffer kept for scrubbing, the id is unique for the lifetime of the renderer and identifies rendered frames in the cache
+struct HeldBuffer {
+	Frame frame;
+	quint64 id;
+};
+
+//FrameRenderer lives in the converter thread and turns received frames into QImages that are already in display format, mapping raw samples through the selected colormap in a single pass. Only the newest frame is kept: frames that arrive while a conversion is running replace each other and the GUI thread picks up the newest finished image once per display refresh.
+//In progressive mode frames may be enqueued before they are completely received. Only the lines that arrived since the last call are rendered and handed to the GUI thread as bands. All bands of a frame are normalized with the same range, the range of the previous complete frame.
+//An optional spatial filter runs on complete frames only. Frames are normalized to 16 bit, filtered in tiles by a WorkerPool and each tile is mapped through the colormap by the thread that filtered it.
+//Any frame of a buffer can be selected for display. If the history is enabled the most recent buffers are kept; in hold mode the live stream is paused and frames of these buffers are rendered on demand and kept in a FrameCache, so scrubbing back and forth does not convert frames again.
+class FrameRenderer : public QObject
+{
+	Q_OBJECT
+public:
+	//unsigned samples use the full range of their bit depth by default, signed and float samples are normalized to the minimum and maximum of each frame
+	enum RangeMode {
+		DefaultRange,
+		MinMaxRange,
+		WindowRange
+	};
+
+	explicit FrameRenderer(QObject *parent = nullptr);
+	~FrameRenderer();
+
+	void enqueueFrame(Frame frame, int availableLines = -1);
+	bool takeImage(QImage& image, FrameInfo& info);
+	bool takeBands(QList<ImageBand>& bands);
+	int takeReceivedFrameCount();
+	void scrubTo(int bufferAge, int frameIndex);
+	//must be called in the converter thread
+	void setWorkerThreadTuning(const ThreadTuning& tuning);
+
+private:
+	bool prepareImage(int width, int height);
+	bool renderFrame(const Frame& frame, int frameIndex);
+	bool renderLines(const Frame& frame, int frameIndex, QImage& image, int firstLine, int lineCount, bool keepRange = false);
+	bool renderFilteredFrame(const Frame& frame, const uchar* input, QImage& image);
+	bool updateRange(const Frame& frame, const uchar* input, int lineCount, bool keepRange);
+	void renderBand(const Frame& frame, int availableLines);
+	void showHeldFrame();
+	void clearHistory();
+
+	QMutex mutex;
+	Frame pendingFrame;
+	int pendingLines;
+	bool renderScheduled;
+	QList<ImageBand> readyBands;
+	QImage readyImage;
+	FrameInfo readyInfo;
+	bool imageAvailable;
+
+	QImage workImage;
+	ColorMap colorMap;
+	RangeMode rangeMode;
+	float windowMin;
+	float windowMax;
+	float rangeMin;
+	float rangeMax;
+	QVector<quint16> lineBuffer;
+	QAtomicInt receivedFrames;
+	bool progressive;
+	const FrameBuffer* progressBuffer; //identifies the progressively rendered frame together with its sequence number, no reference is kept
+	quint64 progressSequenceNumber;
+	bool progressCompleted;
+	int renderedLines;
+	bool bandRangeValid;
+	unsigned int bandRangeBitDepth;
+	SampleFormat bandRangeFormat;
+	float bandRangeMin;
+	float bandRangeMax;
+
+	QList<HeldBuffer> history; //oldest first, guarded by mutex
+	qint64 historyBytes;
+	quint64 nextBufferId;
+	bool historyEnabled;
+	bool holding;
+	int pendingScrubBuffer;
+	int pendingScrubFrame;
+	bool scrubScheduled;
+	QList<HeldBuffer> heldBuffers;
+	FrameCache frameCache;
+	int selectedFrame;
+	int scrubBuffer;
+	int scrubFrame;
+	int lastFramesPerBuffer;
+
+	SpatialFilter filter;
+	WorkerPool* workerPool; //created with the first filtered frame
+	ThreadTuning workerTuning;
+	QVector<quint16> filterInput;
+	QVector<quint16> filterOutput;
+
+public slots:
+	void setColorMap(int type);
+	void setValueRange(int mode, double minValue, double maxValue);
+	void setProgressive(bool enable);
+	void setHistoryEnabled(bool enable);
+	void setSelectedFrame(int frameIndex);
+	void setHold(bool enable);
+	void setFilter(int type);
+
+private slots:
+	void renderPendingFrame();
+	void renderScrubRequest();
+
+signals:
+	void scrubRangeChanged(int bufferCount, int framesPerBuffer); //bufferCount is the number of held buffers, 0 if not in hold mode
+	void info(QString);
+	void error(QString);
+};
+
+#endif // FRAMERENDERER_H
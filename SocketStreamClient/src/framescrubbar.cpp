@@ -0,0 +1,102 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+
+#include "framescrubbar.h"
+#include <QHBoxLayout>
+#include <QSignalBlocker>
+
+
+FrameScrubBar::FrameScrubBar(QWidget *parent) : QWidget(parent)
+{
+	this->bufferCount = 0;
+
+	this->holdCheckBox = new QCheckBox(tr("Hold"), this);
+	this->holdCheckBox->setToolTip(tr("Pause the live display and browse the recently received buffers"));
+	this->bufferSpinBox = new QSpinBox(this);
+	this->bufferSpinBox->setRange(0, 0);
+	this->bufferSpinBox->setEnabled(false);
+	this->bufferSpinBox->setToolTip(tr("0 is the newest held buffer, older buffers have negative numbers"));
+	this->frameSlider = new QSlider(Qt::Horizontal, this);
+	this->frameSlider->setRange(0, 0);
+	this->frameSlider->setPageStep(1);
+	this->frameLabel = new QLabel(this);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+	this->frameLabel->setMinimumWidth(this->frameLabel->fontMetrics().horizontalAdvance("0000 / 0000"));
+#else
+	this->frameLabel->setMinimumWidth(this->frameLabel->fontMetrics().width("0000 / 0000"));
+#endif
+
+	QHBoxLayout* layout = new QHBoxLayout(this);
+	layout->setContentsMargins(0, 0, 0, 0);
+	layout->addWidget(this->holdCheckBox);
+	layout->addWidget(new QLabel(tr("Buffer"), this));
+	layout->addWidget(this->bufferSpinBox);
+	layout->addWidget(new QLabel(tr("Frame"), this));
+	layout->addWidget(this->frameSlider, 1);
+	layout->addWidget(this->frameLabel);
+	this->updateLabel();
+
+	connect(this->holdCheckBox, &QCheckBox::toggled, this, [this](bool checked) {
+		{
+			QSignalBlocker bufferBlocker(this->bufferSpinBox);
+			this->bufferSpinBox->setValue(0);
+			this->bufferSpinBox->setEnabled(checked && this->bufferCount > 1);
+		}
+		emit holdChanged(checked);
+		this->emitSelection(); //the selected frame applies to the held buffers or to the live stream
+	});
+	connect(this->bufferSpinBox, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &FrameScrubBar::emitSelection);
+	connect(this->frameSlider, &QSlider::valueChanged, this, [this]() {
+		this->updateLabel();
+		this->emitSelection();
+	});
+}
+
+void FrameScrubBar::setRange(int bufferCount, int framesPerBuffer) {
+	//adjusting the ranges must not be reported back as a new selection
+	this->bufferCount = bufferCount;
+	{
+		QSignalBlocker bufferBlocker(this->bufferSpinBox);
+		QSignalBlocker frameBlocker(this->frameSlider);
+		this->bufferSpinBox->setRange(-qMax(0, bufferCount - 1), 0);
+		this->bufferSpinBox->setEnabled(this->holdCheckBox->isChecked() && bufferCount > 1);
+		this->frameSlider->setRange(0, qMax(0, framesPerBuffer - 1));
+	}
+	this->updateLabel();
+}
+
+void FrameScrubBar::setHold(bool enable) {
+	this->holdCheckBox->setChecked(enable);
+}
+
+void FrameScrubBar::emitSelection() {
+	emit frameSelected(-this->bufferSpinBox->value(), this->frameSlider->value());
+}
+
+void FrameScrubBar::updateLabel() {
+	this->frameLabel->setText(QString("%1 / %2").arg(this->frameSlider->value() + 1).arg(this->frameSlider->maximum() + 1));
+}
@@ -0,0 +1,63 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+
+#ifndef FRAMESCRUBBAR_H
+#define FRAMESCRUBBAR_H
+
+#include <QWidget>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QSlider>
+#include <QLabel>
+
+//Selects the displayed frame within a buffer. In hold mode the live stream is paused and the recently received buffers can be browsed, buffer 0 is the newest one and older buffers have negative numbers.
+class FrameScrubBar : public QWidget
+{
+	Q_OBJECT
+public:
+	explicit FrameScrubBar(QWidget *parent = nullptr);
+
+private:
+	void emitSelection();
+	void updateLabel();
+
+	QCheckBox* holdCheckBox;
+	QSpinBox* bufferSpinBox;
+	QSlider* frameSlider;
+	QLabel* frameLabel;
+	int bufferCount;
+
+public slots:
+	void setRange(int bufferCount, int framesPerBuffer);
+	void setHold(bool enable);
+
+signals:
+	void holdChanged(bool enabled);
+	void frameSelected(int bufferAge, int frameIndex);
+};
+
+#endif // FRAMESCRUBBAR_H
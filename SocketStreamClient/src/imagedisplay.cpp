@@ -25,13 +25,15 @@
 **/
 
 #include "imagedisplay.h"
-#include <QDebug>
-
-#include "imagedisplay.h"
+#include "receivetimestamp.h"
+#include "streamrequest.h"
 #include <QDebug>
 #include <QContextMenuEvent>
 #include <QMenu>
 #include <QAction>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QInputDialog>
 
 ImageDisplay::ImageDisplay(QWidget *parent) : QGraphicsView(parent)
 {
@@ -40,11 +42,11 @@ ImageDisplay::ImageDisplay(QWidget *parent) : QGraphicsView(parent)
 	//scene->setSceneRect(0, 0, this->width(), this->height());
 	setScene(scene);
 	setCacheMode(CacheBackground);
-	setViewportUpdateMode(BoundingRectViewportUpdate);
-	setRenderHint(QPainter::Antialiasing);
+	setViewportUpdateMode(FullViewportUpdate); //the scene consists of one pixmap that covers the view, computing update regions is not worth it
+	setOptimizationFlags(DontSavePainterState | DontAdjustForAntialiasing);
 	setTransformationAnchor(AnchorUnderMouse);
 
-	this->inputItem = new QGraphicsPixmapItem();
+	this->inputItem = new ImageItem();
 	this->scene->addItem(inputItem);
 	this->scene->update();
 
@@ -53,20 +55,46 @@ ImageDisplay::ImageDisplay(QWidget *parent) : QGraphicsView(parent)
 	this->mousePosX = 0;
 	this->mousePosY = 0;
 
-	//setup bitconverter
-	this->bitConverter = new BitDepthConverter();
-	this->bitConverter->moveToThread(&converterThread);
-	connect(this, &ImageDisplay::non8bitFrameReceived, this->bitConverter, &BitDepthConverter::convertDataTo8bit);
-	connect(this->bitConverter, &BitDepthConverter::info, this, &ImageDisplay::info);
-	connect(this->bitConverter, &BitDepthConverter::error, this, &ImageDisplay::error);
-	connect(this->bitConverter, &BitDepthConverter::converted8bitData, this, &ImageDisplay::displayFrame);
-	connect(&converterThread, &QThread::finished, this->bitConverter, &BitDepthConverter::deleteLater);
+	//setup renderer that prepares images in the converter thread
+	this->renderer = new FrameRenderer();
+	this->renderer->moveToThread(&converterThread);
+	connect(this->renderer, &FrameRenderer::info, this, &ImageDisplay::info);
+	connect(this->renderer, &FrameRenderer::error, this, &ImageDisplay::error);
+	connect(this->renderer, &FrameRenderer::scrubRangeChanged, this, &ImageDisplay::scrubRangeChanged);
+	connect(&converterThread, &QThread::finished, this->renderer, &FrameRenderer::deleteLater);
 	converterThread.start();
+	this->colorMapType = ColorMap::Gray;
+	this->rangeMode = FrameRenderer::DefaultRange;
+	this->windowMin = 0.0;
+	this->windowMax = 1.0;
+	this->progressive = false;
+	this->holding = false;
+	this->filterType = SpatialFilter::None;
+	this->regionRequests = false;
+	this->pendingSampleStep = 1;
+	this->pendingLineStep = 1;
+	this->regionTimer.setSingleShot(true);
+	this->regionTimer.setInterval(REGION_REQUEST_DELAY_MS);
+	connect(&regionTimer, &QTimer::timeout, this, [this]() {
+		emit visibleRegionChanged(this->pendingRegion, this->pendingSampleStep, this->pendingLineStep);
+	});
+
+	//the newest prepared image is shown once per display refresh, independent of the stream rate
+	qreal refreshRate = 60.0;
+	QScreen* screen = QGuiApplication::primaryScreen();
+	if(screen != nullptr && screen->refreshRate() > 1.0){
+		refreshRate = screen->refreshRate();
+	}
+	this->refreshTimer.setTimerType(Qt::PreciseTimer);
+	connect(&refreshTimer, &QTimer::timeout, this, &ImageDisplay::refreshDisplay);
+	this->refreshTimer.start(qMax(1, qRound(1000.0 / refreshRate)));
 
 	//setup FPS display
 	this->showFps = false;
 	this->frameCount = 0;
 	this->currentFps = 0.0;
+	this->latencySumUs = 0;
+	this->latencyCount = 0;
 	this->fpsLabel = new QLabel(this);
 	this->fpsLabel->setStyleSheet("QLabel { color : white; background-color: rgba(0, 0, 0, 128); }");
 	this->fpsLabel->setText("FPS: 0            ");
@@ -88,11 +116,20 @@ ImageDisplay::~ImageDisplay()
 	converterThread.wait();
 }
 
+void ImageDisplay::applyConverterThreadTuning(const ThreadTuning& tuning) {
+	tuning.applyToThreadOf(this->renderer, "converter");
+}
+
+void ImageDisplay::applyWorkerThreadTuning(const ThreadTuning& tuning) {
+	FrameRenderer* renderer = this->renderer;
+	QMetaObject::invokeMethod(renderer, [renderer, tuning]() { renderer->setWorkerThreadTuning(tuning); }, Qt::QueuedConnection);
+}
+
 void ImageDisplay::mouseDoubleClickEvent(QMouseEvent *event) {
 	this->fitInView(this->scene->sceneRect(), Qt::KeepAspectRatio);
 	this->ensureVisible(this->inputItem);
 	this->centerOn(this->pos());
-	this->scene->setSceneRect(this->scene->itemsBoundingRect());
+	this->scene->setSceneRect(0, 0, this->frameWidth, this->frameHeight);
 	QGraphicsView::mousePressEvent(event);
 }
 
@@ -159,43 +196,154 @@ void ImageDisplay::zoomOut() {
 	this->scaleView(1/qreal(1.2));
 }
 
-void ImageDisplay::receiveFrame(void *frame, unsigned int bitDepth, unsigned int samplesPerLine, unsigned int linesPerFrame) {
-	//if(bitDepth != 8){
-		emit non8bitFrameReceived(frame, bitDepth, samplesPerLine, linesPerFrame);
-	//}else{
-	//	this->displayFrame(static_cast<uchar*>(frame), samplesPerLine, linesPerFrame);
-	//}
+void ImageDisplay::receiveFrame(Frame frame) {
+	//called directly from the receiver thread, frames are only handed over to the renderer
+	this->renderer->enqueueFrame(frame);
+}
+
+void ImageDisplay::receiveFrameProgress(Frame frame, int completedLines) {
+	//called directly from the receiver thread while the rest of the frame is still being received
+	this->renderer->enqueueFrame(frame, completedLines);
+}
+
+void ImageDisplay::setScrubbingEnabled(bool enable) {
+	//recent buffers are only kept while frames can be selected
+	if(!enable){
+		this->holding = false;
+	}
+	QMetaObject::invokeMethod(this->renderer, "setHistoryEnabled", Qt::QueuedConnection, Q_ARG(bool, enable));
 }
 
-void ImageDisplay::displayFrame(uchar* frame, unsigned int samplesPerLine, unsigned int linesPerFrame) {
-	//create QPixmap from uchar array and update inputItem
-	QImage image(frame, samplesPerLine, linesPerFrame, QImage::Format_Grayscale8 );
-	this->inputItem->setPixmap(QPixmap::fromImage(image));
+void ImageDisplay::setHold(bool enable) {
+	this->holding = enable;
+	QMetaObject::invokeMethod(this->renderer, "setHold", Qt::QueuedConnection, Q_ARG(bool, enable));
+}
 
+void ImageDisplay::selectFrame(int bufferAge, int frameIndex) {
+	if(this->holding){
+		this->renderer->scrubTo(bufferAge, frameIndex);
+	}else{
+		QMetaObject::invokeMethod(this->renderer, "setSelectedFrame", Qt::QueuedConnection, Q_ARG(int, frameIndex));
+	}
+}
+
+void ImageDisplay::setRegionRequestsEnabled(bool enable) {
+	this->regionRequests = enable;
+	this->visibleRect = QRectF(); //the current view is requested with the next refresh
+	if(!enable){
+		this->regionTimer.stop();
+	}
+}
+
+void ImageDisplay::refreshDisplay() {
+	this->checkVisibleRegion();
+
+	//lines of partially received frames are written into the displayed image in place
+	if(this->renderer->takeBands(this->bands)){
+		for(const ImageBand& band : this->bands){
+			if(this->inputItem->imageSize() != QSize(band.frameWidth, band.frameHeight)){
+				this->inputItem->resetImage(band.frameWidth, band.frameHeight);
+			}
+			this->placeImage(band.info);
+			this->inputItem->updateLines(band.image, band.firstLine);
+			if(band.firstLine + band.image.height() >= band.frameHeight){
+				this->addLatency(band.info);
+			}
+		}
+		this->bands.clear();
+	}
+
+	FrameInfo info;
+	if(!this->renderer->takeImage(this->displayImage, info)){
+		return;
+	}
+	//the previously displayed image is swapped back and reused by the renderer
+	this->inputItem->swapImage(this->displayImage);
+	this->placeImage(info);
+	this->addLatency(info);
+}
+
+void ImageDisplay::placeImage(const FrameInfo& info) {
+	//every received sample covers sampleStep x lineStep samples of the full frame
+	int fullWidth = static_cast<int>(info.fullWidth > 0 ? info.fullWidth : info.samplesPerLine);
+	int fullHeight = static_cast<int>(info.fullHeight > 0 ? info.fullHeight : info.linesPerFrame);
+	QPointF position(info.regionX, info.regionY);
+	QTransform scaling = QTransform::fromScale(qMax(1u, info.sampleStep), qMax(1u, info.lineStep));
+	if(this->inputItem->pos() != position){
+		this->inputItem->setPos(position);
+	}
+	if(this->inputItem->transform() != scaling){
+		this->inputItem->setTransform(scaling);
+	}
+	this->fitFrameSize(fullWidth, fullHeight);
+}
+
+void ImageDisplay::checkVisibleRegion() {
+	//polled once per display refresh, so zooming, panning and resizing are all covered
+	if(!this->regionRequests || this->frameWidth <= 0 || this->frameHeight <= 0){
+		return;
+	}
+	QRectF visible = this->mapToScene(this->viewport()->rect()).boundingRect();
+	if(visible == this->visibleRect){
+		return;
+	}
+	this->visibleRect = visible;
+
+	//a margin around the visible region keeps small pans from showing empty borders until the next buffer arrives
+	qreal marginX = visible.width() / REGION_REQUEST_MARGIN;
+	qreal marginY = visible.height() / REGION_REQUEST_MARGIN;
+	QRectF region = visible.adjusted(-marginX, -marginY, marginX, marginY).intersected(QRectF(0, 0, this->frameWidth, this->frameHeight));
+	if(region.isEmpty()){
+		return;
+	}
+	//samples that share one screen pixel do not need to be sent
+	qreal pixelRatio = this->devicePixelRatioF();
+	qreal minScale = 1.0 / StreamRequest::MAX_STEP;
+	QRect alignedRegion = region.toAlignedRect();
+	this->pendingRegion = alignedRegion == QRect(0, 0, this->frameWidth, this->frameHeight) ? QRect() : alignedRegion;
+	this->pendingSampleStep = qBound(1, qFloor(1.0 / qMax(qAbs(this->transform().m11()) * pixelRatio, minScale)), StreamRequest::MAX_STEP);
+	this->pendingLineStep = qBound(1, qFloor(1.0 / qMax(qAbs(this->transform().m22()) * pixelRatio, minScale)), StreamRequest::MAX_STEP);
+	this->regionTimer.start();
+}
+
+void ImageDisplay::fitFrameSize(int width, int height) {
 	//scale view if input sizes have changed
-	if(this->frameWidth != samplesPerLine || this->frameHeight != linesPerFrame){
-		this->frameWidth = samplesPerLine;
-		this->frameHeight = linesPerFrame;
+	if(this->frameWidth != width || this->frameHeight != height){
+		this->frameWidth = width;
+		this->frameHeight = height;
 		this->fitInView(this->scene->sceneRect(), Qt::KeepAspectRatio);
 		this->ensureVisible(this->inputItem);
 		this->centerOn(this->pos());
 
-		//set scene rect back to minimal size
-		this->scene->setSceneRect(this->scene->itemsBoundingRect());
+		//set scene rect back to the full frame, the image may only cover a region of it
+		this->scene->setSceneRect(0, 0, width, height);
 	}
+}
 
-	// Increment frame count for FPS calculation
-	frameCount++;
+void ImageDisplay::addLatency(const FrameInfo& info) {
+	// Acquisition-to-display latency, only available if the sender provides timestamps
+	if(info.senderTimestampUs > 0){
+		this->latencySumUs += ReceiveTimestamp::currentTimeUs() - info.senderTimestampUs;
+		this->latencyCount++;
+	}
 }
 
 void ImageDisplay::updateFps() {
+	frameCount = this->renderer->takeReceivedFrameCount();
 	currentFps = static_cast<double>(frameCount)/(this->fpsTimeInterval/1000);
 	frameCount = 0;
 
 	if(showFps){
 		//fpsLabel->setText(" " + QString::number(currentFps));
-		fpsLabel->setText(QString("FPS: %1").arg(currentFps, 0, 'f', 0));
+		QString text = QString("FPS: %1").arg(currentFps, 0, 'f', 0);
+		if(this->latencyCount > 0){
+			text += QString("  Latency: %1 ms").arg(static_cast<double>(this->latencySumUs) / this->latencyCount / 1000.0, 0, 'f', 1);
+		}
+		fpsLabel->setText(text);
+		fpsLabel->adjustSize();
 	}
+	this->latencySumUs = 0;
+	this->latencyCount = 0;
 }
 
 void ImageDisplay::contextMenuEvent(QContextMenuEvent* event) {
@@ -205,5 +353,76 @@ void ImageDisplay::contextMenuEvent(QContextMenuEvent* event) {
 		showFps = !showFps;
 		fpsLabel->setVisible(showFps);
 	});
+	QMenu* colorMapMenu = menu.addMenu(tr("Colormap"));
+	QStringList colorMapNames = ColorMap::names();
+	for(int i = 0; i < colorMapNames.size(); i++){
+		QAction* colorMapAction = colorMapMenu->addAction(colorMapNames.at(i));
+		colorMapAction->setCheckable(true);
+		colorMapAction->setChecked(i == this->colorMapType);
+		connect(colorMapAction, &QAction::triggered, this, [this, i]() {
+			this->colorMapType = static_cast<ColorMap::Type>(i);
+			QMetaObject::invokeMethod(this->renderer, "setColorMap", Qt::QueuedConnection, Q_ARG(int, i));
+		});
+	}
+	QMenu* rangeMenu = menu.addMenu(tr("Value range"));
+	QAction* defaultRangeAction = rangeMenu->addAction(tr("Full bit depth (unsigned) / frame min-max"));
+	QAction* minMaxRangeAction = rangeMenu->addAction(tr("Frame min-max"));
+	QAction* windowRangeAction = rangeMenu->addAction(tr("Window..."));
+	defaultRangeAction->setCheckable(true);
+	minMaxRangeAction->setCheckable(true);
+	windowRangeAction->setCheckable(true);
+	defaultRangeAction->setChecked(this->rangeMode == FrameRenderer::DefaultRange);
+	minMaxRangeAction->setChecked(this->rangeMode == FrameRenderer::MinMaxRange);
+	windowRangeAction->setChecked(this->rangeMode == FrameRenderer::WindowRange);
+	connect(defaultRangeAction, &QAction::triggered, this, [this]() {
+		this->rangeMode = FrameRenderer::DefaultRange;
+		QMetaObject::invokeMethod(this->renderer, "setValueRange", Qt::QueuedConnection, Q_ARG(int, this->rangeMode), Q_ARG(double, this->windowMin), Q_ARG(double, this->windowMax));
+	});
+	connect(minMaxRangeAction, &QAction::triggered, this, [this]() {
+		this->rangeMode = FrameRenderer::MinMaxRange;
+		QMetaObject::invokeMethod(this->renderer, "setValueRange", Qt::QueuedConnection, Q_ARG(int, this->rangeMode), Q_ARG(double, this->windowMin), Q_ARG(double, this->windowMax));
+	});
+	connect(windowRangeAction, &QAction::triggered, this, [this]() {
+		bool ok = false;
+		double minValue = QInputDialog::getDouble(this, tr("Window"), tr("Minimum value:"), this->windowMin, -1e12, 1e12, 4, &ok);
+		if(!ok){
+			return;
+		}
+		double maxValue = QInputDialog::getDouble(this, tr("Window"), tr("Maximum value:"), qMax(this->windowMax, minValue), minValue, 1e12, 4, &ok);
+		if(!ok){
+			return;
+		}
+		this->rangeMode = FrameRenderer::WindowRange;
+		this->windowMin = minValue;
+		this->windowMax = maxValue;
+		QMetaObject::invokeMethod(this->renderer, "setValueRange", Qt::QueuedConnection, Q_ARG(int, this->rangeMode), Q_ARG(double, this->windowMin), Q_ARG(double, this->windowMax));
+	});
+	QMenu* filterMenu = menu.addMenu(tr("Filter"));
+	QStringList filterNames = SpatialFilter::names();
+	for(int i = 0; i < filterNames.size(); i++){
+		QAction* filterAction = filterMenu->addAction(filterNames.at(i));
+		filterAction->setCheckable(true);
+		filterAction->setChecked(i == this->filterType);
+		connect(filterAction, &QAction::triggered, this, [this, i]() {
+			this->filterType = static_cast<SpatialFilter::Type>(i);
+			QMetaObject::invokeMethod(this->renderer, "setFilter", Qt::QueuedConnection, Q_ARG(int, i));
+		});
+	}
+	//every image row is one A-scan
+	int lineIndex = qFloor(this->mapToScene(event->pos()).y());
+	if(lineIndex >= 0 && lineIndex < this->frameHeight){
+		QAction* plotLineAction = menu.addAction(tr("Plot A-scan %1").arg(lineIndex));
+		connect(plotLineAction, &QAction::triggered, this, [this, lineIndex]() {
+			emit lineSelected(lineIndex);
+		});
+	}
+	QAction* progressiveAction = menu.addAction(tr("Progressive display"));
+	progressiveAction->setCheckable(true);
+	progressiveAction->setChecked(this->progressive);
+	connect(progressiveAction, &QAction::triggered, this, [this](bool checked) {
+		this->progressive = checked;
+		QMetaObject::invokeMethod(this->renderer, "setProgressive", Qt::QueuedConnection, Q_ARG(bool, checked));
+		emit progressiveModeChanged(checked);
+	});
 	menu.exec(event->globalPos());
 }
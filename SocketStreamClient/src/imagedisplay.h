@@ -29,7 +29,6 @@
 
 #include <QWidget>
 #include <QGraphicsView>
-#include <QGraphicsPixmapItem>
 #include <QThread>
 #include <QKeyEvent>
 #include <QWheelEvent>
@@ -37,8 +36,15 @@
 #include <QTimer>
 #include <QContextMenuEvent>
 #include <QLabel>
-#include "bitdepthconverter.h"
+#include <QRect>
+#include "framerenderer.h"
+#include "imageitem.h"
+#include "threadtuning.h"
 
+#define REGION_REQUEST_DELAY_MS 250 //the visible region is requested once the view has not changed for this long
+#define REGION_REQUEST_MARGIN 8 //the requested region extends the visible region by 1/REGION_REQUEST_MARGIN of its size on every side
+
+//Scene coordinates are samples and lines of the full frame. Received frames that only contain a region of it (see StreamRequest) are placed and scaled accordingly, so zooming and panning stay consistent while the region changes.
 class ImageDisplay : public QGraphicsView
 {
 	Q_OBJECT
@@ -48,6 +54,9 @@ public:
 	explicit ImageDisplay(QWidget *parent = nullptr);
 	~ImageDisplay();
 
+	void applyConverterThreadTuning(const ThreadTuning& tuning);
+	void applyWorkerThreadTuning(const ThreadTuning& tuning);
+
 private:
 	void mouseDoubleClickEvent(QMouseEvent* event) override;
 	void mousePressEvent(QMouseEvent* event) override;
@@ -56,11 +65,17 @@ private:
 	void wheelEvent(QWheelEvent* event) override;
 	void contextMenuEvent(QContextMenuEvent* event) override;
 	void scaleView(qreal scaleFactor);
+	void fitFrameSize(int width, int height);
+	void placeImage(const FrameInfo& info);
+	void checkVisibleRegion();
+	void addLatency(const FrameInfo& info);
 
 private:
-	BitDepthConverter* bitConverter;
+	FrameRenderer* renderer;
+	QTimer refreshTimer;
+	QImage displayImage;
 	QGraphicsScene* scene;
-	QGraphicsPixmapItem* inputItem;
+	ImageItem* inputItem;
 	int frameWidth;
 	int frameHeight;
 	int mousePosX;
@@ -73,20 +88,44 @@ private:
 	int frameCount;
 	double currentFps;
 	int fpsTimeInterval;
+	qint64 latencySumUs;
+	int latencyCount;
+	ColorMap::Type colorMapType;
+	FrameRenderer::RangeMode rangeMode;
+	double windowMin;
+	double windowMax;
+	bool progressive;
+	bool holding;
+	SpatialFilter::Type filterType;
+	QList<ImageBand> bands;
+	bool regionRequests;
+	QRectF visibleRect;
+	QRect pendingRegion;
+	int pendingSampleStep;
+	int pendingLineStep;
+	QTimer regionTimer;
 
 public slots:
 	void zoomIn();
 	void zoomOut();
-	void receiveFrame(void* frame, unsigned int bitDepth, unsigned int samplesPerLine, unsigned int linesPerFrame);
-	void displayFrame(uchar* frame, unsigned int samplesPerLine, unsigned int linesPerFrame);
+	void receiveFrame(Frame frame);
+	void receiveFrameProgress(Frame frame, int completedLines);
+	void setScrubbingEnabled(bool enable);
+	void setHold(bool enable);
+	void selectFrame(int bufferAge, int frameIndex);
+	void setRegionRequestsEnabled(bool enable);
 
 private slots:
+	void refreshDisplay();
 	void updateFps();
 
 signals:
-	void non8bitFrameReceived(void *frame, unsigned int bitDepth, unsigned int samplesPerLine, unsigned int linesPerFrame);
 	void info(QString);
 	void error(QString);
+	void progressiveModeChanged(bool enabled);
+	void lineSelected(int lineIndex);
+	void visibleRegionChanged(QRect region, int sampleStep, int lineStep); //region in samples and lines of the full frame (empty if the full frame is visible), the steps follow from the zoom factor
+	void scrubRangeChanged(int bufferCount, int framesPerBuffer);
 };
 
 #endif // IMAGEDISPLAY_H
@@ -0,0 +1,73 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "imageitem.h"
+#include <QPainter>
+
+
+ImageItem::ImageItem(QGraphicsItem *parent) : QGraphicsItem(parent)
+{
+}
+
+QRectF ImageItem::boundingRect() const {
+	return QRectF(0, 0, this->image.width(), this->image.height());
+}
+
+void ImageItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+	Q_UNUSED(option)
+	Q_UNUSED(widget)
+	if(!this->image.isNull()){
+		painter->drawImage(0, 0, this->image);
+	}
+}
+
+void ImageItem::swapImage(QImage& image) {
+	//the previous image is handed back to the caller so its memory can be reused
+	if(image.size() != this->image.size()){
+		this->prepareGeometryChange();
+	}
+	this->image.swap(image);
+	this->update();
+}
+
+void ImageItem::resetImage(int width, int height) {
+	this->prepareGeometryChange();
+	this->image = QImage(width, height, QImage::Format_RGB32);
+	this->image.fill(Qt::black);
+	this->update();
+}
+
+void ImageItem::updateLines(const QImage& lines, int firstLine) {
+	if(this->image.isNull() || lines.width() != this->image.width() || lines.format() != this->image.format()){
+		return;
+	}
+	int lineCount = qMin(lines.height(), this->image.height() - firstLine);
+	int bytesPerLine = qMin(lines.bytesPerLine(), this->image.bytesPerLine());
+	for(int y = 0; y < lineCount; y++){
+		memcpy(this->image.scanLine(firstLine + y), lines.constScanLine(y), bytesPerLine);
+	}
+	this->update(QRectF(0, firstLine, this->image.width(), lineCount));
+}
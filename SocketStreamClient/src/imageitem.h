@@ -0,0 +1,51 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef IMAGEITEM_H
+#define IMAGEITEM_H
+
+#include <QGraphicsItem>
+#include <QImage>
+
+//Graphics item that draws a QImage directly. In contrast to QGraphicsPixmapItem the image can be exchanged without conversion and single lines can be updated in place, which is needed for the progressive display.
+class ImageItem : public QGraphicsItem
+{
+public:
+	explicit ImageItem(QGraphicsItem *parent = nullptr);
+
+	QRectF boundingRect() const override;
+	void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
+
+	void swapImage(QImage& image);
+	void resetImage(int width, int height);
+	void updateLines(const QImage& lines, int firstLine);
+	QSize imageSize() const { return this->image.size(); }
+
+private:
+	QImage image;
+};
+
+#endif // IMAGEITEM_H
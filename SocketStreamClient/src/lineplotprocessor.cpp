@@ -0,0 +1,297 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "lineplotprocessor.h"
+#include <QMutexLocker>
+#include <QtMath>
+#include <limits>
+
+namespace {
+	//the selected line is a line of the full frame, frames that only contain a region of it use the nearest received line
+	int receivedLine(const FrameInfo& info, int fullFrameLine) {
+		int lineStep = static_cast<int>(qMax(1u, info.lineStep));
+		return qBound(0, (fullFrameLine - static_cast<int>(info.regionY) + lineStep / 2) / lineStep, static_cast<int>(info.linesPerFrame) - 1);
+	}
+
+	template<typename T>
+	void samplesToFloat(const uchar* input, float* output, int length) {
+		const T* samples = reinterpret_cast<const T*>(input);
+		for(int i = 0; i < length; i++){
+			output[i] = static_cast<float>(samples[i]);
+		}
+	}
+
+	bool lineToFloat(const uchar* input, float* output, int length, int bitDepth, SampleFormat format) {
+		int bytesPerSample = qCeil(static_cast<double>(bitDepth) / 8.0);
+		if(format == SampleFormat::Float){
+			if(bitDepth != 32){
+				return false;
+			}
+			memcpy(output, input, length * sizeof(float));
+			return true;
+		}
+		bool isSigned = format == SampleFormat::Signed;
+		switch(bytesPerSample){
+		case 1: isSigned ? samplesToFloat<qint8>(input, output, length) : samplesToFloat<quint8>(input, output, length); return true;
+		case 2: isSigned ? samplesToFloat<qint16>(input, output, length) : samplesToFloat<quint16>(input, output, length); return true;
+		case 4: isSigned ? samplesToFloat<qint32>(input, output, length) : samplesToFloat<quint32>(input, output, length); return true;
+		default: return false;
+		}
+	}
+}
+
+
+LinePlotProcessor::LinePlotProcessor(QObject *parent) : QObject(parent)
+{
+	this->ringInfo = FrameInfo();
+	this->ringBytesPerLine = 0;
+	this->writtenLines = 0;
+	this->processedLines = 0;
+	this->processScheduled = false;
+	this->geometryChanged = true;
+	this->updateAvailable = false;
+	this->selectedLine.storeRelease(0);
+	this->plotWidth.storeRelease(512);
+	this->mModeEnabled.storeRelease(1);
+	this->mModeMin = 0.0f;
+	this->mModeMax = 0.0f;
+}
+
+void LinePlotProcessor::enqueueFrame(const Frame& frame) {
+	//called on the receiver thread, only the selected line of the first frame in the buffer is copied
+	const FrameInfo& info = frame->info;
+	int bytesPerSample = qCeil(static_cast<double>(info.bitDepth) / 8.0);
+	int bytesPerLine = static_cast<int>(info.samplesPerLine) * bytesPerSample;
+	if(bytesPerLine <= 0 || info.linesPerFrame == 0){
+		return;
+	}
+	int line = receivedLine(info, this->selectedLine.loadAcquire());
+	if(frame->size() < static_cast<quint32>((line + 1) * bytesPerLine)){
+		return;
+	}
+
+	QMutexLocker locker(&this->mutex);
+	if(this->ringBytesPerLine != bytesPerLine || this->ringInfo.bitDepth != info.bitDepth || this->ringInfo.sampleFormat != info.sampleFormat){
+		this->resetRing(info, bytesPerLine);
+	}
+	this->ringInfo = info;
+	memcpy(this->ring.data() + (this->writtenLines % RING_LINES) * bytesPerLine, frame->constData() + line * bytesPerLine, bytesPerLine);
+	this->writtenLines++;
+	if(!this->processScheduled){
+		this->processScheduled = true;
+		QMetaObject::invokeMethod(this, "processPendingLines", Qt::QueuedConnection);
+	}
+}
+
+bool LinePlotProcessor::takeUpdate(LinePlotUpdate& update) {
+	QMutexLocker locker(&this->mutex);
+	if(!this->updateAvailable){
+		return false;
+	}
+	update = this->pendingUpdate;
+	this->pendingUpdate.newColumns = QImage();
+	this->updateAvailable = false;
+	return true;
+}
+
+void LinePlotProcessor::setLineIndex(int lineIndex) {
+	this->selectedLine.storeRelease(qMax(0, lineIndex));
+	QMutexLocker locker(&this->mutex);
+	this->geometryChanged = true; //M-mode range of the previous line does not apply
+}
+
+void LinePlotProcessor::setPlotWidth(int width) {
+	this->plotWidth.storeRelease(qMax(1, width));
+}
+
+void LinePlotProcessor::setMModeEnabled(bool enable) {
+	this->mModeEnabled.storeRelease(enable ? 1 : 0);
+	QMutexLocker locker(&this->mutex);
+	this->geometryChanged = true; //the M-mode image starts again, so does its range
+}
+
+void LinePlotProcessor::resetRing(const FrameInfo& info, int bytesPerLine) {
+	//only reallocated if the stream geometry changes
+	this->ring.resize(RING_LINES * bytesPerLine);
+	this->ringInfo = info;
+	this->ringBytesPerLine = bytesPerLine;
+	this->writtenLines = 0;
+	this->processedLines = 0;
+	this->geometryChanged = true;
+}
+
+void LinePlotProcessor::processPendingLines() {
+	FrameInfo info;
+	int bytesPerLine;
+	int lineCount;
+	bool resetRange;
+	{
+		QMutexLocker locker(&this->mutex);
+		this->processScheduled = false;
+		if(this->writtenLines - this->processedLines > RING_LINES){
+			this->processedLines = this->writtenLines - RING_LINES; //lines that have been overwritten are skipped
+		}
+		info = this->ringInfo;
+		bytesPerLine = this->ringBytesPerLine;
+		lineCount = static_cast<int>(this->writtenLines - this->processedLines);
+		this->lineBytes.resize(lineCount * bytesPerLine);
+		for(int i = 0; i < lineCount; i++){
+			quint64 ringIndex = (this->processedLines + i) % RING_LINES;
+			memcpy(this->lineBytes.data() + i * bytesPerLine, this->ring.constData() + ringIndex * bytesPerLine, bytesPerLine);
+		}
+		this->processedLines = this->writtenLines;
+		resetRange = this->geometryChanged;
+		this->geometryChanged = false;
+	}
+	if(lineCount == 0){
+		return;
+	}
+
+	int samplesPerLine = static_cast<int>(info.samplesPerLine);
+	int mModeHeight = qMin(samplesPerLine, M_MODE_MAX_HEIGHT);
+	bool mMode = this->mModeEnabled.loadAcquire() != 0;
+	QImage columns;
+	uchar* columnBits = nullptr;
+	int columnBytesPerLine = 0;
+	if(mMode){
+		columns = QImage(lineCount, mModeHeight, QImage::Format_RGB32);
+		columnBits = columns.bits();
+		columnBytesPerLine = columns.bytesPerLine();
+	}
+	this->lineValues.resize(samplesPerLine);
+	if(resetRange){
+		this->mModeMin = std::numeric_limits<float>::max();
+		this->mModeMax = -std::numeric_limits<float>::max();
+	}
+	//without M-mode only the newest line is needed
+	for(int i = mMode ? 0 : lineCount - 1; i < lineCount; i++){
+		if(!lineToFloat(this->lineBytes.constData() + i * bytesPerLine, this->lineValues.data(), samplesPerLine, static_cast<int>(info.bitDepth), info.sampleFormat)){
+			return;
+		}
+		if(mMode){
+			this->appendColumn(this->lineValues, columnBits, columnBytesPerLine, mModeHeight, i);
+		}
+	}
+	//the newest line is shown in the plot
+	LinePlotUpdate update;
+	this->decimate(this->lineValues, this->plotWidth.loadAcquire(), update);
+
+	QMutexLocker locker(&this->mutex);
+	this->pendingUpdate.minValues = update.minValues;
+	this->pendingUpdate.maxValues = update.maxValues;
+	this->pendingUpdate.rangeMin = update.rangeMin;
+	this->pendingUpdate.rangeMax = update.rangeMax;
+	this->pendingUpdate.samplesPerLine = samplesPerLine;
+	this->pendingUpdate.lineIndex = static_cast<int>(info.regionY + receivedLine(info, this->selectedLine.loadAcquire()) * qMax(1u, info.lineStep));
+	QImage& pendingColumns = this->pendingUpdate.newColumns;
+	if(!mMode){
+		pendingColumns = QImage();
+	}else if(this->updateAvailable && !pendingColumns.isNull() && pendingColumns.height() == columns.height()){
+		//the GUI has not picked up the previous columns yet, both are handed over together
+		int keptColumns = qMin(pendingColumns.width(), RING_LINES - columns.width());
+		QImage merged(keptColumns + columns.width(), columns.height(), QImage::Format_RGB32);
+		for(int y = 0; y < merged.height(); y++){
+			quint32* mergedLine = reinterpret_cast<quint32*>(merged.scanLine(y));
+			const quint32* pendingLine = reinterpret_cast<const quint32*>(pendingColumns.constScanLine(y));
+			memcpy(mergedLine, pendingLine + pendingColumns.width() - keptColumns, keptColumns * sizeof(quint32));
+			memcpy(mergedLine + keptColumns, columns.constScanLine(y), columns.width() * sizeof(quint32));
+		}
+		pendingColumns = merged;
+	}else{
+		pendingColumns = columns;
+	}
+	this->updateAvailable = true;
+}
+
+void LinePlotProcessor::decimate(const QVector<float>& line, int bins, LinePlotUpdate& update) {
+	//min/max per pixel column keeps narrow peaks visible, no matter how many samples fall on one pixel
+	int length = line.size();
+	bins = qMin(bins, length);
+	update.minValues.resize(bins);
+	update.maxValues.resize(bins);
+	float rangeMin = std::numeric_limits<float>::max();
+	float rangeMax = -std::numeric_limits<float>::max();
+	for(int bin = 0; bin < bins; bin++){
+		int first = static_cast<int>(static_cast<qint64>(bin) * length / bins);
+		int last = static_cast<int>(static_cast<qint64>(bin + 1) * length / bins);
+		float minValue = line.at(first);
+		float maxValue = line.at(first);
+		for(int i = first + 1; i < last; i++){
+			float value = line.at(i);
+			if(value < minValue){
+				minValue = value;
+			}
+			if(value > maxValue){
+				maxValue = value;
+			}
+		}
+		update.minValues[bin] = minValue;
+		update.maxValues[bin] = maxValue;
+		if(minValue < rangeMin){
+			rangeMin = minValue;
+		}
+		if(maxValue > rangeMax){
+			rangeMax = maxValue;
+		}
+	}
+	update.rangeMin = rangeMin;
+	update.rangeMax = rangeMax;
+}
+
+void LinePlotProcessor::appendColumn(const QVector<float>& line, uchar* columnBits, int bytesPerLine, int height, int column) {
+	//the M-mode intensity range only grows, so older columns stay comparable
+	int length = line.size();
+	this->columnIndices.resize(height);
+	this->columnPixels.resize(height);
+	for(int i = 0; i < length; i++){
+		float value = line.at(i);
+		if(value < this->mModeMin){
+			this->mModeMin = value;
+		}
+		if(value > this->mModeMax){
+			this->mModeMax = value;
+		}
+	}
+	float range = this->mModeMax - this->mModeMin;
+	float scale = range > 0.0f ? 65535.0f / range : 0.0f;
+	for(int y = 0; y < height; y++){
+		int first = static_cast<int>(static_cast<qint64>(y) * length / height);
+		int last = static_cast<int>(static_cast<qint64>(y + 1) * length / height);
+		float maxValue = line.at(first);
+		for(int i = first + 1; i < last; i++){
+			if(line.at(i) > maxValue){
+				maxValue = line.at(i);
+			}
+		}
+		this->columnIndices[y] = static_cast<quint16>(qBound(0.0f, (maxValue - this->mModeMin) * scale, 65535.0f));
+	}
+	this->colorMap.apply(this->columnIndices.constData(), this->columnPixels.data(), 16, height);
+	//rows are addressed through the image bits, scanLine() would check for a detach for every pixel
+	const quint32* pixels = this->columnPixels.constData();
+	for(int y = 0; y < height; y++){
+		reinterpret_cast<quint32*>(columnBits + y * bytesPerLine)[column] = pixels[y];
+	}
+}
@@ -0,0 +1,98 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef LINEPLOTPROCESSOR_H
+#define LINEPLOTPROCESSOR_H
+
+#define RING_LINES 1024 //number of A-scans kept in the ring buffer, also the width of the M-mode image
+#define M_MODE_MAX_HEIGHT 512
+
+#include <QObject>
+#include <QImage>
+#include <QMutex>
+#include <QVector>
+#include <QAtomicInt>
+#include "frame.h"
+#include "colormap.h"
+
+//min/max decimated A-scan and the M-mode columns that were added since the last update
+struct LinePlotUpdate {
+	QVector<float> minValues;
+	QVector<float> maxValues;
+	float rangeMin;
+	float rangeMax;
+	int samplesPerLine;
+	int lineIndex;
+	QImage newColumns;
+};
+
+//LinePlotProcessor copies one A-scan of every received frame into a ring buffer (the only work done on the receiver thread) and processes the buffered lines in its own thread: the newest line is min/max decimated to the pixel width of the plot, every line becomes one column of the M-mode image. The GUI thread only draws the prepared data.
+//While the M-mode view is hidden only the newest line is processed and no columns are created.
+class LinePlotProcessor : public QObject
+{
+	Q_OBJECT
+public:
+	explicit LinePlotProcessor(QObject *parent = nullptr);
+
+	void enqueueFrame(const Frame& frame);
+	bool takeUpdate(LinePlotUpdate& update);
+	void setLineIndex(int lineIndex);
+	int lineIndex() const { return this->selectedLine.loadAcquire(); }
+	void setPlotWidth(int width);
+	void setMModeEnabled(bool enable);
+
+private:
+	void resetRing(const FrameInfo& info, int bytesPerLine);
+	void decimate(const QVector<float>& line, int bins, LinePlotUpdate& update);
+	void appendColumn(const QVector<float>& line, uchar* columnBits, int bytesPerLine, int height, int column);
+
+	QMutex mutex;
+	QVector<uchar> ring;
+	FrameInfo ringInfo;
+	int ringBytesPerLine;
+	quint64 writtenLines;
+	quint64 processedLines;
+	bool processScheduled;
+	bool geometryChanged;
+	LinePlotUpdate pendingUpdate;
+	bool updateAvailable;
+
+	QAtomicInt selectedLine;
+	QAtomicInt plotWidth;
+	QAtomicInt mModeEnabled;
+	QVector<uchar> lineBytes;
+	QVector<float> lineValues;
+	QVector<quint16> columnIndices;
+	QVector<quint32> columnPixels;
+	ColorMap colorMap;
+	float mModeMin;
+	float mModeMax;
+
+private slots:
+	void processPendingLines();
+};
+
+#endif // LINEPLOTPROCESSOR_H
@@ -0,0 +1,226 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "lineplotwidget.h"
+#include <QPainter>
+#include <QMenu>
+#include <QAction>
+#include <QInputDialog>
+#include <QGuiApplication>
+#include <QScreen>
+
+#define PLOT_MARGIN 4
+
+
+LinePlotWidget::LinePlotWidget(QWidget *parent) : QWidget(parent)
+{
+	this->plotAvailable = false;
+	this->mModeColumn = 0;
+	this->showMMode = true;
+	this->active.storeRelease(0);
+	this->setAttribute(Qt::WA_OpaquePaintEvent);
+
+	this->processor = new LinePlotProcessor();
+	this->processor->moveToThread(&processorThread);
+	connect(&processorThread, &QThread::finished, this->processor, &LinePlotProcessor::deleteLater);
+	processorThread.start();
+
+	//like the image display the view is refreshed once per screen refresh, independent of the stream rate
+	qreal refreshRate = 60.0;
+	QScreen* screen = QGuiApplication::primaryScreen();
+	if(screen != nullptr && screen->refreshRate() > 1.0){
+		refreshRate = screen->refreshRate();
+	}
+	this->refreshTimer.setTimerType(Qt::PreciseTimer);
+	this->refreshTimer.setInterval(qMax(1, qRound(1000.0 / refreshRate)));
+	connect(&refreshTimer, &QTimer::timeout, this, &LinePlotWidget::refresh);
+}
+
+LinePlotWidget::~LinePlotWidget()
+{
+	processorThread.quit();
+	processorThread.wait();
+}
+
+void LinePlotWidget::receiveFrame(Frame frame) {
+	//called directly from the receiver thread, frames are ignored while the view is hidden
+	if(this->active.loadAcquire() != 0){
+		this->processor->enqueueFrame(frame);
+	}
+}
+
+void LinePlotWidget::setLineIndex(int lineIndex) {
+	this->processor->setLineIndex(lineIndex);
+	this->mModeImage.fill(Qt::black);
+	this->mModeColumn = 0;
+	this->update();
+}
+
+void LinePlotWidget::refresh() {
+	LinePlotUpdate update;
+	if(!this->processor->takeUpdate(update)){
+		return;
+	}
+	if(!update.newColumns.isNull()){
+		this->addColumns(update.newColumns);
+		update.newColumns = QImage();
+	}
+	this->plot = update;
+	this->plotAvailable = true;
+	this->update();
+}
+
+void LinePlotWidget::addColumns(const QImage& columns) {
+	//the M-mode image is a ring of RING_LINES columns, mModeColumn is the next column to be written
+	if(this->mModeImage.height() != columns.height()){
+		this->mModeImage = QImage(RING_LINES, columns.height(), QImage::Format_RGB32);
+		this->mModeImage.fill(Qt::black);
+		this->mModeColumn = 0;
+	}
+	//copied row by row through the image bits, scanLine() would check for a detach for every pixel
+	uchar* targetBits = this->mModeImage.bits();
+	int targetBytesPerLine = this->mModeImage.bytesPerLine();
+	const uchar* sourceBits = columns.constBits();
+	int sourceBytesPerLine = columns.bytesPerLine();
+	int width = qMin(columns.width(), RING_LINES);
+	int skipped = columns.width() - width; //only the newest RING_LINES columns are visible
+	for(int y = 0; y < columns.height(); y++){
+		quint32* target = reinterpret_cast<quint32*>(targetBits + y * targetBytesPerLine);
+		const quint32* source = reinterpret_cast<const quint32*>(sourceBits + y * sourceBytesPerLine) + skipped;
+		int column = this->mModeColumn;
+		for(int x = 0; x < width; x++){
+			target[column] = source[x];
+			column = column + 1 == RING_LINES ? 0 : column + 1;
+		}
+	}
+	this->mModeColumn = (this->mModeColumn + width) % RING_LINES;
+}
+
+void LinePlotWidget::paintEvent(QPaintEvent* event) {
+	Q_UNUSED(event)
+	QPainter painter(this);
+	painter.fillRect(this->rect(), Qt::black);
+	QRect area = this->rect().adjusted(PLOT_MARGIN, PLOT_MARGIN, -PLOT_MARGIN, -PLOT_MARGIN);
+	if(this->showMMode){
+		QRect plotArea(area.left(), area.top(), area.width(), area.height() / 2 - PLOT_MARGIN);
+		QRect mModeArea(area.left(), area.top() + area.height() / 2, area.width(), area.height() - area.height() / 2);
+		this->drawPlot(painter, plotArea);
+		this->drawMMode(painter, mModeArea);
+	}else{
+		this->drawPlot(painter, area);
+	}
+}
+
+void LinePlotWidget::drawPlot(QPainter& painter, const QRect& area) {
+	painter.setPen(QColor(60, 60, 60));
+	painter.drawRect(area);
+	int bins = this->plot.minValues.size();
+	if(!this->plotAvailable || bins == 0 || area.width() <= 0 || area.height() <= 0){
+		return;
+	}
+
+	//one vertical span per pixel column covers all samples that were decimated into it
+	float range = this->plot.rangeMax - this->plot.rangeMin;
+	double yScale = range > 0.0f ? area.height() / static_cast<double>(range) : 0.0;
+	double xStep = static_cast<double>(area.width()) / bins;
+	QVector<QLineF> lines;
+	lines.reserve(2 * bins);
+	QPointF previous;
+	for(int bin = 0; bin < bins; bin++){
+		double x = area.left() + (bin + 0.5) * xStep;
+		double yMin = area.bottom() - (this->plot.minValues.at(bin) - this->plot.rangeMin) * yScale;
+		double yMax = area.bottom() - (this->plot.maxValues.at(bin) - this->plot.rangeMin) * yScale;
+		QPointF center(x, (yMin + yMax) / 2.0);
+		lines.append(QLineF(x, yMin, x, yMax));
+		if(bin > 0){
+			lines.append(QLineF(previous, center));
+		}
+		previous = center;
+	}
+	painter.setPen(QColor(80, 220, 120));
+	painter.drawLines(lines);
+
+	painter.setPen(Qt::white);
+	painter.drawText(area.adjusted(PLOT_MARGIN, PLOT_MARGIN, -PLOT_MARGIN, -PLOT_MARGIN), Qt::AlignTop | Qt::AlignLeft,
+		tr("A-scan %1 (%2 samples)  %3 - %4").arg(this->plot.lineIndex).arg(this->plot.samplesPerLine).arg(this->plot.rangeMin, 0, 'g', 5).arg(this->plot.rangeMax, 0, 'g', 5));
+}
+
+void LinePlotWidget::drawMMode(QPainter& painter, const QRect& area) {
+	if(this->mModeImage.isNull() || area.width() <= 0 || area.height() <= 0){
+		return;
+	}
+	//oldest column first, the ring is drawn in two parts
+	int olderColumns = RING_LINES - this->mModeColumn;
+	int splitX = area.left() + area.width() * olderColumns / RING_LINES;
+	QRect olderTarget(area.left(), area.top(), splitX - area.left(), area.height());
+	QRect newerTarget(splitX, area.top(), area.right() + 1 - splitX, area.height());
+	painter.drawImage(olderTarget, this->mModeImage, QRect(this->mModeColumn, 0, olderColumns, this->mModeImage.height()));
+	if(this->mModeColumn > 0){
+		painter.drawImage(newerTarget, this->mModeImage, QRect(0, 0, this->mModeColumn, this->mModeImage.height()));
+	}
+}
+
+void LinePlotWidget::resizeEvent(QResizeEvent* event) {
+	//decimation to the pixel width of the plot
+	this->processor->setPlotWidth(this->width() - 2 * PLOT_MARGIN);
+	QWidget::resizeEvent(event);
+}
+
+void LinePlotWidget::showEvent(QShowEvent* event) {
+	this->active.storeRelease(1);
+	this->refreshTimer.start();
+	QWidget::showEvent(event);
+}
+
+void LinePlotWidget::hideEvent(QHideEvent* event) {
+	this->active.storeRelease(0);
+	this->refreshTimer.stop();
+	QWidget::hideEvent(event);
+}
+
+void LinePlotWidget::contextMenuEvent(QContextMenuEvent* event) {
+	QMenu menu(this);
+	QAction* selectLineAction = menu.addAction(tr("Select A-scan..."));
+	connect(selectLineAction, &QAction::triggered, this, [this]() {
+		bool ok = false;
+		int lineIndex = QInputDialog::getInt(this, tr("A-scan"), tr("A-scan index:"), this->processor->lineIndex(), 0, 65535, 1, &ok);
+		if(ok){
+			this->setLineIndex(lineIndex);
+		}
+	});
+	QAction* mModeAction = menu.addAction(tr("Show M-mode"));
+	mModeAction->setCheckable(true);
+	mModeAction->setChecked(this->showMMode);
+	connect(mModeAction, &QAction::triggered, this, [this](bool checked) {
+		this->showMMode = checked;
+		this->processor->setMModeEnabled(checked);
+		//columns are not created while M-mode is hidden, the image starts again without a gap
+		this->mModeImage.fill(Qt::black);
+		this->mModeColumn = 0;
+		this->update();
+	});
+	menu.exec(event->globalPos());
+}
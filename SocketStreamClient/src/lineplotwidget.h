@@ -0,0 +1,77 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef LINEPLOTWIDGET_H
+#define LINEPLOTWIDGET_H
+
+#include <QWidget>
+#include <QThread>
+#include <QTimer>
+#include <QImage>
+#include <QAtomicInt>
+#include <QContextMenuEvent>
+#include "lineplotprocessor.h"
+
+//A-scan view: line plot of the selected A-scan and optionally an M-mode image that shows this A-scan over time (time from left to right, newest column on the right)
+class LinePlotWidget : public QWidget
+{
+	Q_OBJECT
+	QThread processorThread;
+
+public:
+	explicit LinePlotWidget(QWidget *parent = nullptr);
+	~LinePlotWidget();
+
+protected:
+	void paintEvent(QPaintEvent* event) override;
+	void resizeEvent(QResizeEvent* event) override;
+	void showEvent(QShowEvent* event) override;
+	void hideEvent(QHideEvent* event) override;
+	void contextMenuEvent(QContextMenuEvent* event) override;
+
+private:
+	void addColumns(const QImage& columns);
+	void drawPlot(QPainter& painter, const QRect& area);
+	void drawMMode(QPainter& painter, const QRect& area);
+
+	LinePlotProcessor* processor;
+	QTimer refreshTimer;
+	LinePlotUpdate plot;
+	bool plotAvailable;
+	QImage mModeImage;
+	int mModeColumn;
+	bool showMMode;
+	QAtomicInt active;
+
+public slots:
+	void receiveFrame(Frame frame);
+	void setLineIndex(int lineIndex);
+
+private slots:
+	void refresh();
+};
+
+#endif // LINEPLOTWIDGET_H
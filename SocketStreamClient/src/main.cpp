@@ -1,12 +1,54 @@
 #include "socketstreamclient.h"
+#include "benchmark.h"
+#include "soaktest.h"
+#include "testserver.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+#include <QDebug>
 
 int main(int argc, char *argv[])
 {
+	//headless modes do not need a window system
+	if(Benchmark::isRequested(argc, argv)){
+		QCoreApplication a(argc, argv);
+		return Benchmark::run();
+	}
+	if(SoakTest::isRequested(argc, argv)){
+		QCoreApplication a(argc, argv);
+		SoakTest soakTest;
+		if(!soakTest.configure(a.arguments())){
+			return 2;
+		}
+		QTimer::singleShot(0, &soakTest, &SoakTest::start);
+		return a.exec();
+	}
+
 	QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 	QApplication a(argc, argv);
+	QCommandLineParser parser;
+	parser.addHelpOption();
+	QCommandLineOption testServerOption("test-server", "Starts a local test server on the given port that streams synthetic 1024x512x16x4 buffers and honors region requests.", "port");
+	parser.addOption(testServerOption);
+	ThreadSettings::addOptions(parser);
+	parser.process(a);
+	ThreadSettings threadSettings;
+	QString errorMessage;
+	if(!threadSettings.fromParser(parser, errorMessage)){
+		qCritical() << errorMessage;
+		return 2;
+	}
+	if(parser.isSet(testServerOption)){
+		TestServer* testServer = new TestServer(&a);
+		if(!testServer->listen(static_cast<quint16>(parser.value(testServerOption).toUInt()))){
+			qCritical() << "Could not start the test server on port" << parser.value(testServerOption);
+			return 2;
+		}
+	}
+
 	SocketStreamClient w;
+	w.applyThreadSettings(threadSettings);
 	w.show();
 	return a.exec();
 }
@@ -0,0 +1,93 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "memoryusage.h"
+
+#if defined(Q_OS_LINUX)
+#include <cstdio>
+#include <unistd.h>
+#include <malloc.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+
+qint64 MemoryUsage::residentSetSize() {
+#if defined(Q_OS_LINUX)
+	long pages = 0;
+	long residentPages = 0;
+	FILE* file = fopen("/proc/self/statm", "r");
+	if(file == nullptr){
+		return -1;
+	}
+	int fields = fscanf(file, "%ld %ld", &pages, &residentPages);
+	fclose(file);
+	if(fields != 2){
+		return -1;
+	}
+	return static_cast<qint64>(residentPages) * sysconf(_SC_PAGESIZE);
+#elif defined(Q_OS_WIN)
+	PROCESS_MEMORY_COUNTERS counters;
+	if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))){
+		return -1;
+	}
+	return static_cast<qint64>(counters.WorkingSetSize);
+#else
+	return -1;
+#endif
+}
+
+qint64 MemoryUsage::heapInUse() {
+#if defined(Q_OS_LINUX) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 info = mallinfo2();
+	return static_cast<qint64>(info.uordblks + info.hblkhd);
+#elif defined(Q_OS_LINUX) && defined(__GLIBC__)
+	struct mallinfo info = mallinfo();
+	return static_cast<qint64>(static_cast<unsigned int>(info.uordblks)) + static_cast<unsigned int>(info.hblkhd);
+#elif defined(Q_OS_WIN)
+	PROCESS_MEMORY_COUNTERS_EX counters;
+	if(!GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters))){
+		return -1;
+	}
+	return static_cast<qint64>(counters.PrivateUsage);
+#else
+	return -1;
+#endif
+}
+
+qint64 MemoryUsage::heapMapped() {
+	//large allocations such as frame buffers are served by mmap and returned to the system on free
+#if defined(Q_OS_LINUX) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 info = mallinfo2();
+	return static_cast<qint64>(info.hblkhd);
+#elif defined(Q_OS_LINUX) && defined(__GLIBC__)
+	struct mallinfo info = mallinfo();
+	return static_cast<qint64>(static_cast<unsigned int>(info.hblkhd));
+#else
+	return -1;
+#endif
+}
@@ -0,0 +1,80 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "receivetimestamp.h"
+#include <chrono>
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <linux/net_tstamp.h>
+#include <linux/errqueue.h>
+#endif
+
+
+qint64 ReceiveTimestamp::currentTimeUs() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool ReceiveTimestamp::enableKernelTimestamps(qintptr socketDescriptor) {
+#ifdef Q_OS_LINUX
+	//software timestamps use the same clock as currentTimeUs(), hardware timestamps would need PHC synchronization
+	int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+	return setsockopt(static_cast<int>(socketDescriptor), SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0;
+#else
+	Q_UNUSED(socketDescriptor)
+	return false;
+#endif
+}
+
+qint64 ReceiveTimestamp::peekKernelTimestampUs(qintptr socketDescriptor) {
+#ifdef Q_OS_LINUX
+	//peek at the data that is still queued in the kernel, nothing is consumed
+	char data;
+	char control[256];
+	struct iovec iov;
+	iov.iov_base = &data;
+	iov.iov_len = sizeof(data);
+	struct msghdr msg = {};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	if(recvmsg(static_cast<int>(socketDescriptor), &msg, MSG_PEEK | MSG_DONTWAIT) <= 0){
+		return 0;
+	}
+	for(struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)){
+		if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPING){
+			const struct scm_timestamping* timestamps = reinterpret_cast<const struct scm_timestamping*>(CMSG_DATA(cmsg));
+			const struct timespec& softwareTimestamp = timestamps->ts[0];
+			return static_cast<qint64>(softwareTimestamp.tv_sec) * 1000000 + softwareTimestamp.tv_nsec / 1000;
+		}
+	}
+	return 0;
+#else
+	Q_UNUSED(socketDescriptor)
+	return 0;
+#endif
+}
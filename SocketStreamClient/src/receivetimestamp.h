@@ -0,0 +1,41 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef RECEIVETIMESTAMP_H
+#define RECEIVETIMESTAMP_H
+
+#include <QtGlobal>
+
+//timestamps in microseconds since the Unix epoch. Kernel receive timestamps (SO_TIMESTAMPING) are only available on Linux, elsewhere the software clock is used.
+class ReceiveTimestamp
+{
+public:
+	static qint64 currentTimeUs();
+	static bool enableKernelTimestamps(qintptr socketDescriptor);
+	static qint64 peekKernelTimestampUs(qintptr socketDescriptor);
+};
+
+#endif // RECEIVETIMESTAMP_H
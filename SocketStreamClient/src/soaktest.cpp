@@ -0,0 +1,363 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "soaktest.h"
+#include "memoryusage.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDebug>
+
+#define BYTES_PER_MB (1024.0 * 1024.0)
+#define PRESENT_INTERVAL_MS 16
+#define RENDERER_FRAME_HOLDERS (SCRUB_HISTORY_BUFFERS + 3) //scrub history, the frame being received, the pending frame and the frame being converted
+#define LEAK_SAMPLES 3 //consecutive samples above the live frame baseline that count as a leak
+
+
+SoakTest::SoakTest(QObject *parent) : QObject(parent), out(stdout)
+{
+	this->receiver = nullptr;
+	this->renderer = nullptr;
+	this->testServer = nullptr;
+	this->useTestServer = true;
+	this->filterType = 0;
+	this->durationSeconds = 0;
+	this->intervalSeconds = 10;
+	this->warmupSeconds = 0;
+	this->maxGrowthBytes = 64 * 1024 * 1024;
+	this->lastSampleMs = 0;
+	this->framesLost = 0;
+	this->checksumFailures = 0;
+	this->arrivalJitterMs = 0.0;
+	this->latencyJitterMs = 0.0;
+	this->baselineResidentSize = -1;
+	this->baselineHeap = -1;
+	this->baselineLiveFrames = -1;
+	this->leakSamples = 0;
+	this->peakResidentSize = 0;
+	this->wasConnected = false;
+	this->finished = false;
+
+	this->serverParams.bitDepth = 16;
+	this->serverParams.sampleFormat = SampleFormat::Unsigned;
+	this->serverParams.samplesPerLine = 1024;
+	this->serverParams.linesPerFrame = 512;
+	this->serverParams.framesPerBuffer = 4;
+	this->serverParams.buffersPerSecond = 50;
+	this->serverParams.autoStart = true;
+	this->serverParams.corruptEvery = 0;
+}
+
+SoakTest::~SoakTest()
+{
+	receiverThread.quit();
+	receiverThread.wait();
+	converterThread.quit();
+	converterThread.wait();
+}
+
+bool SoakTest::isRequested(int argc, char *argv[]) {
+	for(int i = 1; i < argc; i++){
+		if(QString(argv[i]) == "--soak"){
+			return true;
+		}
+	}
+	return false;
+}
+
+bool SoakTest::configure(const QStringList& arguments) {
+	QCommandLineParser parser;
+	parser.setApplicationDescription("SocketStreamClient soak test");
+	parser.addHelpOption();
+	QCommandLineOption soakOption("soak", "Run the soak test for <seconds>.", "seconds");
+	QCommandLineOption intervalOption("soak-interval", "Sampling interval in seconds (default 10).", "seconds", "10");
+	QCommandLineOption warmupOption("soak-warmup", "Seconds until the memory baseline is taken (default: a quarter of the duration, at most 60).", "seconds");
+	QCommandLineOption growthOption("soak-max-growth", "Allowed memory growth after warm-up in MB (default 64).", "MB", "64");
+	QCommandLineOption logOption("soak-log", "Also write the samples as CSV to <file>.", "file");
+	QCommandLineOption serverOption("soak-server", "Use an external server instead of the local test server.", "ip:port");
+	QCommandLineOption geometryOption("soak-geometry", "Buffer geometry of the local test server (default 1024x512x16x4).", "samplesxlinesxbitsxframes", "1024x512x16x4");
+	QCommandLineOption rateOption("soak-rate", "Buffers per second sent by the local test server (default 50).", "buffers", "50");
+	QCommandLineOption formatOption("soak-format", "Sample format of the local test server: unsigned, signed or float (default unsigned).", "format", "unsigned");
+	QCommandLineOption corruptOption("soak-corrupt", "Let the local test server corrupt every n-th buffer after computing its checksum (default 0, off). Checksum failures only fail the test if this is off.", "n", "0");
+	QCommandLineOption filterOption("soak-filter", "Display filter: 0 off, 1 Gaussian (sigma 1), 2 Gaussian (sigma 2), 3 median 3x3, 4 median 5x5, 5 despeckle (default 0).", "filter", "0");
+	parser.addOptions({soakOption, intervalOption, warmupOption, growthOption, logOption, serverOption, geometryOption, rateOption, formatOption, corruptOption, filterOption});
+	ThreadSettings::addOptions(parser);
+	parser.process(arguments);
+
+	QString errorMessage;
+	if(!this->threadSettings.fromParser(parser, errorMessage)){
+		qCritical() << "SoakTest:" << errorMessage;
+		return false;
+	}
+
+	this->durationSeconds = parser.value(soakOption).toInt();
+	this->intervalSeconds = qMax(1, parser.value(intervalOption).toInt());
+	this->warmupSeconds = parser.isSet(warmupOption) ? parser.value(warmupOption).toInt() : qMin(60, this->durationSeconds / 4);
+	this->maxGrowthBytes = static_cast<qint64>(parser.value(growthOption).toDouble() * BYTES_PER_MB);
+	if(this->durationSeconds <= 0){
+		qCritical() << "SoakTest: Invalid duration, use --soak <seconds>";
+		return false;
+	}
+
+	QStringList geometry = parser.value(geometryOption).split('x');
+	if(geometry.size() != 4){
+		qCritical() << "SoakTest: Invalid geometry" << parser.value(geometryOption);
+		return false;
+	}
+	this->serverParams.samplesPerLine = geometry.at(0).toInt();
+	this->serverParams.linesPerFrame = geometry.at(1).toInt();
+	this->serverParams.bitDepth = geometry.at(2).toInt();
+	this->serverParams.framesPerBuffer = geometry.at(3).toInt();
+	QString format = parser.value(formatOption);
+	if(format == "unsigned"){
+		this->serverParams.sampleFormat = SampleFormat::Unsigned;
+	}else if(format == "signed"){
+		this->serverParams.sampleFormat = SampleFormat::Signed;
+	}else if(format == "float" && this->serverParams.bitDepth == 32){
+		this->serverParams.sampleFormat = SampleFormat::Float;
+	}else{
+		qCritical() << "SoakTest: Invalid sample format" << format << "(float samples require a bit depth of 32)";
+		return false;
+	}
+	this->serverParams.buffersPerSecond = qMax(1, parser.value(rateOption).toInt());
+	this->serverParams.corruptEvery = qMax(0, parser.value(corruptOption).toInt());
+	this->filterType = parser.value(filterOption).toInt();
+	if(this->filterType < SpatialFilter::None || this->filterType > SpatialFilter::Despeckle){
+		qCritical() << "SoakTest: Invalid filter" << parser.value(filterOption);
+		return false;
+	}
+
+	this->receiverParams.ip = "127.0.0.1";
+	this->receiverParams.port = 0;
+	this->receiverParams.bitDepth = this->serverParams.bitDepth;
+	this->receiverParams.sampleFormat = this->serverParams.sampleFormat;
+	this->receiverParams.samplesPerLine = this->serverParams.samplesPerLine;
+	this->receiverParams.linesPerFrame = this->serverParams.linesPerFrame;
+	this->receiverParams.framesPerBuffer = this->serverParams.framesPerBuffer;
+	this->receiverParams.useHeaders = true;
+	if(parser.isSet(serverOption)){
+		QStringList address = parser.value(serverOption).split(':');
+		if(address.size() != 2){
+			qCritical() << "SoakTest: Invalid server address" << parser.value(serverOption);
+			return false;
+		}
+		this->useTestServer = false;
+		this->receiverParams.ip = address.at(0);
+		this->receiverParams.port = static_cast<qint16>(address.at(1).toInt());
+	}
+
+	if(parser.isSet(logOption)){
+		this->logFile.setFileName(parser.value(logOption));
+		if(!this->logFile.open(QIODevice::WriteOnly | QIODevice::Text)){
+			qCritical() << "SoakTest: Could not open log file" << parser.value(logOption);
+			return false;
+		}
+	}
+	return true;
+}
+
+void SoakTest::start() {
+	if(this->useTestServer){
+		this->testServer = new TestServer(this);
+		this->testServer->setParams(this->serverParams);
+		if(!this->testServer->listen(0)){
+			this->fail("local test server could not be started");
+			return;
+		}
+		this->receiverParams.port = static_cast<qint16>(this->testServer->port());
+	}
+
+	//same thread layout as in the GUI application
+	this->renderer = new FrameRenderer();
+	this->renderer->moveToThread(&converterThread);
+	connect(&converterThread, &QThread::finished, this->renderer, &FrameRenderer::deleteLater);
+	converterThread.start();
+	this->threadSettings.converter.applyToThreadOf(this->renderer, "converter");
+	FrameRenderer* filterRenderer = this->renderer;
+	ThreadTuning workerTuning = this->threadSettings.worker;
+	int filterType = this->filterType;
+	QMetaObject::invokeMethod(filterRenderer, [filterRenderer, workerTuning, filterType]() {
+		filterRenderer->setWorkerThreadTuning(workerTuning);
+		filterRenderer->setFilter(filterType);
+	}, Qt::QueuedConnection);
+
+	this->receiver = new DataReceiver();
+	this->framePool = this->receiver->pool();
+	this->receiver->moveToThread(&receiverThread);
+	FrameRenderer* renderer = this->renderer;
+	connect(this->receiver, &DataReceiver::frameReceived, this->receiver, [this, renderer](Frame frame) {
+		this->receivedFrames.fetchAndAddRelaxed(1);
+		this->receivedKiloBytes.fetchAndAddRelaxed(static_cast<int>(frame->size() / 1024));
+		renderer->enqueueFrame(frame);
+	}, Qt::DirectConnection);
+	connect(this->receiver, &DataReceiver::connected, this, &SoakTest::onConnected);
+	connect(this->receiver, &DataReceiver::statisticsUpdated, this, &SoakTest::onStatisticsUpdated);
+	connect(&receiverThread, &QThread::finished, this->receiver, &DataReceiver::deleteLater);
+	receiverThread.start();
+	this->threadSettings.receiver.applyToThreadOf(this->receiver, "receiver");
+
+	DataReceiver* receiver = this->receiver;
+	ReceiverParameters params = this->receiverParams;
+	QMetaObject::invokeMethod(receiver, [receiver, params]() { receiver->updateParamsAndConnect(params); }, Qt::QueuedConnection);
+
+	this->writeLine(QString("# soak test started %1, duration %2 s, interval %3 s, warm-up %4 s, max growth %5 MB, server %6:%7")
+		.arg(QDateTime::currentDateTime().toString(Qt::ISODate)).arg(this->durationSeconds).arg(this->intervalSeconds)
+		.arg(this->warmupSeconds).arg(this->maxGrowthBytes / BYTES_PER_MB, 0, 'f', 1).arg(this->receiverParams.ip).arg(static_cast<quint16>(this->receiverParams.port)));
+	this->writeLine("elapsed_s,rss_mb,heap_mb,heap_mapped_mb,live_frames,pooled_frames,socket_buffer_kb,server_pending_kb,frames_per_s,mb_per_s,frames_lost,arrival_jitter_ms,latency_jitter_ms,checksum_failures");
+
+	this->elapsedTimer.start();
+	connect(&sampleTimer, &QTimer::timeout, this, &SoakTest::sample);
+	connect(&presentTimer, &QTimer::timeout, this, &SoakTest::present);
+	this->sampleTimer.start(this->intervalSeconds * 1000);
+	this->presentTimer.start(PRESENT_INTERVAL_MS);
+}
+
+void SoakTest::present() {
+	//emulates the display refresh of ImageDisplay: the new image is kept until the next refresh and the previously presented one goes back to the renderer for reuse
+	FrameInfo info;
+	this->renderer->takeImage(this->presentedImage, info);
+}
+
+void SoakTest::sample() {
+	if(this->finished){
+		return;
+	}
+	qint64 elapsedMs = this->elapsedTimer.elapsed();
+	double intervalSeconds = qMax<qint64>(1, elapsedMs - this->lastSampleMs) / 1000.0;
+	this->lastSampleMs = elapsedMs;
+
+	qint64 residentSize = MemoryUsage::residentSetSize();
+	qint64 heap = MemoryUsage::heapInUse();
+	qint64 heapMapped = MemoryUsage::heapMapped();
+	int liveFrames = this->framePool->liveFrames();
+	int pooledFrames = this->framePool->pooledFrames();
+	int frames = this->receivedFrames.fetchAndStoreRelaxed(0);
+	int kiloBytes = this->receivedKiloBytes.fetchAndStoreRelaxed(0);
+	double framesPerSecond = frames / intervalSeconds;
+	double megaBytesPerSecond = kiloBytes / 1024.0 / intervalSeconds;
+	this->peakResidentSize = qMax(this->peakResidentSize, residentSize);
+
+	this->writeLine(QString("%1,%2,%3,%4,%5,%6,%7,%8,%9,%10,%11,%12,%13,%14")
+		.arg(elapsedMs / 1000.0, 0, 'f', 1)
+		.arg(residentSize / BYTES_PER_MB, 0, 'f', 2)
+		.arg(heap / BYTES_PER_MB, 0, 'f', 2)
+		.arg(heapMapped / BYTES_PER_MB, 0, 'f', 2)
+		.arg(liveFrames)
+		.arg(pooledFrames)
+		.arg(this->receiver->bufferedBytes() / 1024)
+		.arg(this->testServer != nullptr ? this->testServer->pendingBytes() / 1024 : 0)
+		.arg(framesPerSecond, 0, 'f', 1)
+		.arg(megaBytesPerSecond, 0, 'f', 1)
+		.arg(this->framesLost)
+		.arg(this->arrivalJitterMs, 0, 'f', 3)
+		.arg(this->latencyJitterMs, 0, 'f', 3)
+		.arg(this->checksumFailures));
+
+	bool warmedUp = elapsedMs >= this->warmupSeconds * 1000LL;
+	if(warmedUp && this->baselineResidentSize < 0){
+		this->baselineResidentSize = residentSize;
+		this->baselineHeap = heap;
+		this->baselineLiveFrames = liveFrames;
+		this->writeLine(QString("# memory baseline: rss %1 MB, heap %2 MB, live frames %3").arg(residentSize / BYTES_PER_MB, 0, 'f', 2).arg(heap / BYTES_PER_MB, 0, 'f', 2).arg(liveFrames));
+	}
+
+	if(liveFrames > BUFFERS){
+		this->fail(QString("%1 frames are alive, frames are not being released").arg(liveFrames));
+		return;
+	}
+	//a few frames may be held briefly by the receiver and the renderer, more than that for several samples in a row is a leak
+	if(this->baselineLiveFrames >= 0 && liveFrames > this->baselineLiveFrames + RENDERER_FRAME_HOLDERS){
+		this->leakSamples++;
+		if(this->leakSamples >= LEAK_SAMPLES){
+			this->fail(QString("%1 frames are alive, %2 after warm-up, frames are not being released").arg(liveFrames).arg(this->baselineLiveFrames));
+			return;
+		}
+	}else{
+		this->leakSamples = 0;
+	}
+	if(this->checksumFailures > 0 && this->serverParams.corruptEvery == 0){
+		this->fail(QString("%1 buffers with an invalid payload checksum received").arg(this->checksumFailures));
+		return;
+	}
+	if(warmedUp && frames == 0){
+		this->fail("no frames received during the last interval");
+		return;
+	}
+	if(this->baselineResidentSize >= 0 && residentSize >= 0 && residentSize - this->baselineResidentSize > this->maxGrowthBytes){
+		this->fail(QString("resident memory grew by %1 MB since warm-up (threshold %2 MB)").arg((residentSize - this->baselineResidentSize) / BYTES_PER_MB, 0, 'f', 1).arg(this->maxGrowthBytes / BYTES_PER_MB, 0, 'f', 1));
+		return;
+	}
+	if(this->baselineHeap >= 0 && heap >= 0 && heap - this->baselineHeap > this->maxGrowthBytes){
+		this->fail(QString("heap grew by %1 MB since warm-up (threshold %2 MB)").arg((heap - this->baselineHeap) / BYTES_PER_MB, 0, 'f', 1).arg(this->maxGrowthBytes / BYTES_PER_MB, 0, 'f', 1));
+		return;
+	}
+
+	if(elapsedMs >= this->durationSeconds * 1000LL){
+		this->finish();
+	}
+}
+
+void SoakTest::onConnected(bool connected) {
+	if(connected){
+		this->wasConnected = true;
+	}else if(this->wasConnected && !this->finished){
+		this->fail("connection to server lost");
+	}
+}
+
+void SoakTest::onStatisticsUpdated(StreamStatistics statistics) {
+	this->framesLost = statistics.framesLost();
+	this->arrivalJitterMs = statistics.arrivalJitterMs();
+	this->latencyJitterMs = statistics.latencyJitterMs();
+	this->checksumFailures = statistics.checksumFailures();
+}
+
+void SoakTest::writeLine(const QString& line) {
+	this->out << line << "\n";
+	this->out.flush();
+	if(this->logFile.isOpen()){
+		this->logFile.write(line.toUtf8() + "\n");
+		this->logFile.flush();
+	}
+}
+
+void SoakTest::fail(const QString& reason) {
+	this->finished = true;
+	this->sampleTimer.stop();
+	this->presentTimer.stop();
+	this->writeLine("# SOAK TEST FAILED: " + reason);
+	qCritical().noquote() << "SOAK TEST FAILED:" << reason;
+	QCoreApplication::exit(1);
+}
+
+void SoakTest::finish() {
+	this->finished = true;
+	this->sampleTimer.stop();
+	this->presentTimer.stop();
+	this->writeLine(QString("# SOAK TEST PASSED after %1 s, peak rss %2 MB, frames lost %3, checksum failures %4")
+		.arg(this->elapsedTimer.elapsed() / 1000).arg(this->peakResidentSize / BYTES_PER_MB, 0, 'f', 2).arg(this->framesLost).arg(this->checksumFailures));
+	QCoreApplication::exit(0);
+}
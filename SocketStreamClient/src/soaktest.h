@@ -0,0 +1,109 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef SOAKTEST_H
+#define SOAKTEST_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QImage>
+#include <QAtomicInt>
+#include "datareceiver.h"
+#include "framerenderer.h"
+#include "testserver.h"
+#include "threadtuning.h"
+
+//Headless long-running test, started with --soak <seconds>. Receives from a local TestServer (or an external server), runs the display conversion and periodically records memory usage, live frames, queue depths and throughput. Fails with exit code 1 if memory grows past the allowed threshold after the warm-up phase.
+class SoakTest : public QObject
+{
+	Q_OBJECT
+	QThread receiverThread;
+	QThread converterThread;
+
+public:
+	explicit SoakTest(QObject *parent = nullptr);
+	~SoakTest();
+
+	static bool isRequested(int argc, char *argv[]);
+	bool configure(const QStringList& arguments);
+
+private:
+	void fail(const QString& reason);
+	void finish();
+	void writeLine(const QString& line);
+
+	DataReceiver* receiver;
+	FrameRenderer* renderer;
+	TestServer* testServer;
+	QSharedPointer<FramePool> framePool;
+	ReceiverParameters receiverParams;
+	TestServerParameters serverParams;
+	ThreadSettings threadSettings;
+	bool useTestServer;
+	int filterType;
+
+	int durationSeconds;
+	int intervalSeconds;
+	int warmupSeconds;
+	qint64 maxGrowthBytes;
+
+	QTimer sampleTimer;
+	QTimer presentTimer;
+	QElapsedTimer elapsedTimer;
+	QImage presentedImage;
+	QFile logFile;
+	QTextStream out;
+
+	QAtomicInt receivedFrames;
+	QAtomicInt receivedKiloBytes;
+	qint64 lastSampleMs;
+	quint64 framesLost;
+	quint64 checksumFailures;
+	double arrivalJitterMs;
+	double latencyJitterMs;
+	qint64 baselineResidentSize;
+	qint64 baselineHeap;
+	int baselineLiveFrames;
+	int leakSamples;
+	qint64 peakResidentSize;
+	bool wasConnected;
+	bool finished;
+
+public slots:
+	void start();
+
+private slots:
+	void sample();
+	void present();
+	void onConnected(bool connected);
+	void onStatisticsUpdated(StreamStatistics statistics);
+};
+
+#endif // SOAKTEST_H
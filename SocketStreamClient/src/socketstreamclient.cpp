@@ -27,15 +27,42 @@
 #include "socketstreamclient.h"
 #include "ui_socketstreamclient.h"
 #include <QSpinBox>
+#include <QMenu>
 
 SocketStreamClient::SocketStreamClient(QWidget *parent)
 	: QMainWindow(parent)
 	, ui(new Ui::SocketStreamClient)
 	, connected(false)
+	, visibleSampleStep(1)
+	, visibleLineStep(1)
 {
 	qRegisterMetaType<ReceiverParameters>("ReceiverParameters");
 	ui->setupUi(this);
 	this->imgDisplay = this->ui->widget_imagedisplay;
+	this->linePlot = this->ui->widget_lineplot;
+	this->linePlot->hide();
+	QMenu* viewMenu = this->ui->menubar->addMenu(tr("View"));
+	QAction* linePlotAction = viewMenu->addAction(tr("A-scan plot"));
+	linePlotAction->setCheckable(true);
+	connect(linePlotAction, &QAction::toggled, this->linePlot, &LinePlotWidget::setVisible);
+	connect(this->imgDisplay, &ImageDisplay::lineSelected, this, [this, linePlotAction](int lineIndex) {
+		this->linePlot->setLineIndex(lineIndex);
+		linePlotAction->setChecked(true);
+	});
+	this->frameScrubBar = this->ui->widget_framescrubbar;
+	this->frameScrubBar->hide();
+	QAction* frameScrubAction = viewMenu->addAction(tr("Frame selection"));
+	frameScrubAction->setCheckable(true);
+	connect(frameScrubAction, &QAction::toggled, this, [this](bool checked) {
+		if(!checked){
+			this->frameScrubBar->setHold(false);
+		}
+		this->frameScrubBar->setVisible(checked);
+		this->imgDisplay->setScrubbingEnabled(checked);
+	});
+	connect(this->frameScrubBar, &FrameScrubBar::holdChanged, this->imgDisplay, &ImageDisplay::setHold);
+	connect(this->frameScrubBar, &FrameScrubBar::frameSelected, this->imgDisplay, &ImageDisplay::selectFrame);
+	connect(this->imgDisplay, &ImageDisplay::scrubRangeChanged, this->frameScrubBar, &FrameScrubBar::setRange);
 	this->setValidators();
 	this->disableGui(false);
 
@@ -43,10 +70,15 @@ SocketStreamClient::SocketStreamClient(QWidget *parent)
 		this->params.ip = this->ui->lineEdit_ip->text();
 		this->params.port = this->ui->lineEdit_port->text().toInt();
 		this->params.bitDepth = this->ui->spinBox_bitdepth->value();
+		this->params.sampleFormat = static_cast<SampleFormat>(this->ui->comboBox_sampleFormat->currentIndex());
 		this->params.linesPerFrame = this->ui->spinBox_AscansPerBscan->value();
 		this->params.samplesPerLine = this->ui->spinBox_samplesPerAscan->value();
 		this->params.framesPerBuffer = this->ui->spinBox_BscansPerBuffer->value();
 		this->params.useHeaders = this->ui->checkBox_header->isChecked();
+		if(!StreamHeader::isValidSampleFormat(this->params.bitDepth, this->params.sampleFormat)){
+			this->ui->statusbar->showMessage(tr("Unsupported bit depth %1 for the selected sample format").arg(this->params.bitDepth));
+			return;
+		}
 		emit updateParamsAndConnect(this->params);
 	});
 
@@ -54,17 +86,40 @@ SocketStreamClient::SocketStreamClient(QWidget *parent)
 	this->receiver->moveToThread(&receiverThread);
 	connect(this, &SocketStreamClient::updateParamsAndConnect, this->receiver, &DataReceiver::updateParamsAndConnect);
 	connect(this->ui->pushButton_disconnect, &QPushButton::clicked, this->receiver, &DataReceiver::onDisconnect);
-	connect(this->receiver, &DataReceiver::dataAvailable, this->imgDisplay, &ImageDisplay::receiveFrame);
+	connect(this->receiver, &DataReceiver::frameReceived, this->imgDisplay, &ImageDisplay::receiveFrame, Qt::DirectConnection); //keeps the GUI thread free from per-frame events
+	connect(this->receiver, &DataReceiver::frameReceived, this->linePlot, &LinePlotWidget::receiveFrame, Qt::DirectConnection);
+	connect(this->receiver, &DataReceiver::frameProgress, this->imgDisplay, &ImageDisplay::receiveFrameProgress, Qt::DirectConnection);
+	connect(this->imgDisplay, &ImageDisplay::progressiveModeChanged, this->receiver, &DataReceiver::setProgressiveMode);
 	connect(this->receiver, &DataReceiver::connected, this, &SocketStreamClient::disableGui);
 	connect(this->receiver, &DataReceiver::paramsChanged, this, &SocketStreamClient::updateParamsInGui);
+	connect(this->receiver, &DataReceiver::regionChanged, this, &SocketStreamClient::showRegion);
+	connect(this->receiver, &DataReceiver::statisticsUpdated, this, &SocketStreamClient::showStatistics);
 	connect(&receiverThread, &QThread::finished, this->receiver, &DataReceiver::deleteLater);
 
 	connect(this->ui->pushButton_remoteStart, &QPushButton::clicked, this->receiver, &DataReceiver::onRemoteStartClicked);
 	connect(this->ui->pushButton_remoteStop, &QPushButton::clicked, this->receiver, &DataReceiver::onRemoteStopClicked);
+	connect(this, &SocketStreamClient::streamRequestChanged, this->receiver, &DataReceiver::setStreamRequest);
+	connect(this->imgDisplay, &ImageDisplay::visibleRegionChanged, this, [this](QRect region, int sampleStep, int lineStep) {
+		this->visibleRegion = region;
+		this->visibleSampleStep = sampleStep;
+		this->visibleLineStep = lineStep;
+		this->updateStreamRequest();
+	});
+	connect(this->ui->checkBox_visibleRegion, &QCheckBox::toggled, this, [this](bool checked) {
+		if(!checked){
+			this->visibleRegion = QRect();
+			this->visibleSampleStep = 1;
+			this->visibleLineStep = 1;
+		}
+		this->imgDisplay->setRegionRequestsEnabled(checked);
+		this->updateStreamRequest();
+	});
+	connect(this->ui->spinBox_frameStep, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &SocketStreamClient::updateStreamRequest);
 
 	connect(this->ui->checkBox_header, &QCheckBox::clicked, this, [this](bool checked) {
 		if(!this->connected){
 			this->ui->spinBox_bitdepth->setDisabled(checked);
+			this->ui->comboBox_sampleFormat->setDisabled(checked);
 			this->ui->spinBox_AscansPerBscan->setDisabled(checked);
 			this->ui->spinBox_samplesPerAscan->setDisabled(checked);
 			this->ui->spinBox_BscansPerBuffer->setDisabled(checked);
@@ -83,6 +138,12 @@ SocketStreamClient::~SocketStreamClient()
 	delete ui;
 }
 
+void SocketStreamClient::applyThreadSettings(const ThreadSettings& settings) {
+	settings.receiver.applyToThreadOf(this->receiver, "receiver");
+	this->imgDisplay->applyConverterThreadTuning(settings.converter);
+	this->imgDisplay->applyWorkerThreadTuning(settings.worker);
+}
+
 void SocketStreamClient::setValidators() {
 	QString ipRange = "(([0]{1,3})|([0]{0,2}[1-9]{1})|([0]{0,1}[1-9]{1}[0-9]{1})|(1[0-9]{2})|([2][0-4][0-9])|(25[0-5]))";
 	QRegExp ipRegex("^" + ipRange
@@ -105,14 +166,43 @@ void SocketStreamClient::disableGui(bool disable) {
 	this->connected = disable;
 }
 
+void SocketStreamClient::updateStreamRequest() {
+	//the receiver only sends the request if it differs from the previous one and sends it again after reconnecting
+	StreamRequest request;
+	if(!this->visibleRegion.isEmpty()){
+		request.x = static_cast<quint16>(this->visibleRegion.x());
+		request.y = static_cast<quint16>(this->visibleRegion.y());
+		request.width = static_cast<quint16>(this->visibleRegion.width());
+		request.height = static_cast<quint16>(this->visibleRegion.height());
+	}
+	request.sampleStep = static_cast<quint8>(this->visibleSampleStep);
+	request.lineStep = static_cast<quint8>(this->visibleLineStep);
+	request.frameStep = static_cast<quint8>(this->ui->spinBox_frameStep->value());
+	emit streamRequestChanged(request);
+}
+
 void SocketStreamClient::updateParamsInGui(ReceiverParameters params) {
 	this->ui->lineEdit_ip->setText(params.ip);
 	this->ui->lineEdit_port->setText(QString::number(params.port));
 	this->ui->spinBox_bitdepth->setValue(params.bitDepth);
-	this->ui->spinBox_AscansPerBscan->setValue(params.linesPerFrame);
-	this->ui->spinBox_samplesPerAscan->setValue(params.samplesPerLine);
+	this->ui->comboBox_sampleFormat->setCurrentIndex(static_cast<int>(params.sampleFormat));
+	//the frame size of the stream is shown even if only a region of it is received
+	this->ui->spinBox_AscansPerBscan->setValue(this->fullFrameSize.isValid() ? this->fullFrameSize.height() : params.linesPerFrame);
+	this->ui->spinBox_samplesPerAscan->setValue(this->fullFrameSize.isValid() ? this->fullFrameSize.width() : params.samplesPerLine);
 	this->ui->spinBox_BscansPerBuffer->setValue(params.framesPerBuffer);
 	this->ui->checkBox_header->setChecked(params.useHeaders);
 }
 
+void SocketStreamClient::showStatistics(StreamStatistics statistics) {
+	this->ui->statusbar->showMessage(statistics.toString() + this->regionText);
+}
 
+void SocketStreamClient::showRegion(QRect region, QSize fullSize) {
+	if(region == QRect(QPoint(0, 0), fullSize)){
+		this->fullFrameSize = QSize();
+		this->regionText.clear();
+		return;
+	}
+	this->fullFrameSize = fullSize;
+	this->regionText = QString("  Region: %1x%2 at %3,%4 of %5x%6").arg(region.width()).arg(region.height()).arg(region.x()).arg(region.y()).arg(fullSize.width()).arg(fullSize.height());
+}
@@ -34,7 +34,10 @@
 #include <QTcpSocket>
 #include <QRegExpValidator>
 #include "imagedisplay.h"
+#include "framescrubbar.h"
+#include "lineplotwidget.h"
 #include "datareceiver.h"
+#include "threadtuning.h"
 
 
 QT_BEGIN_NAMESPACE
@@ -50,22 +53,35 @@ public:
 	SocketStreamClient(QWidget *parent = nullptr);
 	~SocketStreamClient();
 
+	void applyThreadSettings(const ThreadSettings& settings);
+
 private:
 	Ui::SocketStreamClient *ui;
 	ImageDisplay* imgDisplay;
+	LinePlotWidget* linePlot;
+	FrameScrubBar* frameScrubBar;
 	DataReceiver* receiver;
 	ReceiverParameters params;
 	bool connected;
+	QRect visibleRegion;
+	int visibleSampleStep;
+	int visibleLineStep;
+	QSize fullFrameSize; //size of the full frame if only a region of it is received, otherwise invalid
+	QString regionText;
 
 private:
 	void setValidators();
 	void disableGui(bool disable);
+	void updateStreamRequest();
 
 public slots:
 	void updateParamsInGui(ReceiverParameters params);
+	void showStatistics(StreamStatistics statistics);
+	void showRegion(QRect region, QSize fullSize);
 
 signals:
 	void updateParamsAndConnect(ReceiverParameters);
+	void streamRequestChanged(StreamRequest request);
 
 };
 #endif // SOCKETSTREAMCLIENT_H
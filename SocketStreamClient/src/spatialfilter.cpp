@@ -0,0 +1,471 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+
+#include "spatialfilter.h"
+#include "cpufeatures.h"
+#include <QtMath>
+#include <QVarLengthArray>
+#include <cstring>
+
+#ifdef SSC_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#define DESPECKLE_RADIUS 2
+
+namespace {
+	//per thread buffers, tiles of one image are filtered by several threads at once
+	struct Scratch {
+		QVector<float> padded;
+		QVector<float> paddedSquared;
+		QVector<float> horizontal;
+		QVector<float> horizontalSquared;
+		QVector<float> mean;
+		QVector<float> meanSquared;
+		QVector<float> line;
+	};
+	thread_local Scratch scratch;
+
+	inline int clampIndex(int index, int size) {
+		return index < 0 ? 0 : (index >= size ? size - 1 : index);
+	}
+
+	inline quint16 toSample(float value) {
+		return static_cast<quint16>(qBound(0.0f, value + 0.5f, 65535.0f));
+	}
+
+#ifdef SSC_X86_SIMD
+	//the AVX2 kernels return the number of samples they processed, the scalar code does the rest
+	SSC_TARGET_AVX2 int loadRowAvx2(const quint16* row, float* output, int width) {
+		int x = 0;
+		for(; x + 8 <= width; x += 8){
+			__m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+			_mm256_storeu_ps(output + x, _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(values)));
+		}
+		return x;
+	}
+
+	SSC_TARGET_AVX2 int horizontalPassAvx2(const float* padded, float* output, int width, const float* kernel, int taps) {
+		int x = 0;
+		for(; x + 8 <= width; x += 8){
+			__m256 sum = _mm256_setzero_ps();
+			for(int k = 0; k < taps; k++){
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(kernel[k]), _mm256_loadu_ps(padded + x + k)));
+			}
+			_mm256_storeu_ps(output + x, sum);
+		}
+		return x;
+	}
+
+	SSC_TARGET_AVX2 int verticalPassAvx2(const float* const* rows, float* output, int width, const float* kernel, int taps) {
+		int x = 0;
+		for(; x + 8 <= width; x += 8){
+			__m256 sum = _mm256_setzero_ps();
+			for(int k = 0; k < taps; k++){
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(kernel[k]), _mm256_loadu_ps(rows[k] + x)));
+			}
+			_mm256_storeu_ps(output + x, sum);
+		}
+		return x;
+	}
+
+	SSC_TARGET_AVX2 int storeRowAvx2(const float* input, quint16* output, int width) {
+		int x = 0;
+		for(; x + 16 <= width; x += 16){
+			//packus saturates to 0 - 65535 but interleaves the 128 bit lanes of both inputs
+			__m256i low = _mm256_cvtps_epi32(_mm256_loadu_ps(input + x));
+			__m256i high = _mm256_cvtps_epi32(_mm256_loadu_ps(input + x + 8));
+			__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), 0xD8);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + x), packed);
+		}
+		return x;
+	}
+
+	SSC_TARGET_AVX2 int despeckleRowAvx2(const float* means, const float* meanSquares, const quint16* input, float* output, int width, float noiseVariance, float& varianceSum) {
+		__m256 noise = _mm256_set1_ps(noiseVariance);
+		__m256 zero = _mm256_setzero_ps();
+		__m256 sums = zero;
+		int x = 0;
+		for(; x + 8 <= width; x += 8){
+			__m256 mean = _mm256_loadu_ps(means + x);
+			__m256 variance = _mm256_max_ps(zero, _mm256_sub_ps(_mm256_loadu_ps(meanSquares + x), _mm256_mul_ps(mean, mean)));
+			//the weight is 0 where the variance does not exceed the noise, which also covers a variance of 0
+			__m256 excess = _mm256_max_ps(zero, _mm256_sub_ps(variance, noise));
+			__m256 weight = _mm256_and_ps(_mm256_div_ps(excess, variance), _mm256_cmp_ps(excess, zero, _CMP_GT_OQ));
+			__m256 sample = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + x))));
+			_mm256_storeu_ps(output + x, _mm256_add_ps(mean, _mm256_mul_ps(weight, _mm256_sub_ps(sample, mean))));
+			sums = _mm256_add_ps(sums, variance);
+		}
+		float lanes[8];
+		_mm256_storeu_ps(lanes, sums);
+		for(float lane : lanes){
+			varianceSum += lane;
+		}
+		return x;
+	}
+#endif
+
+	//edge samples are repeated into the padding
+	void loadPaddedRow(const quint16* row, float* padded, int width, int radius) {
+		int x = 0;
+#ifdef SSC_X86_SIMD
+		if(CpuFeatures::hasAvx2()){
+			x = loadRowAvx2(row, padded + radius, width);
+		}
+#endif
+		for(; x < width; x++){
+			padded[radius + x] = row[x];
+		}
+		for(int i = 0; i < radius; i++){
+			padded[i] = row[0];
+			padded[radius + width + i] = row[width - 1];
+		}
+	}
+
+	void square(const float* input, float* output, int length) {
+		for(int i = 0; i < length; i++){
+			output[i] = input[i] * input[i];
+		}
+	}
+
+	void horizontalPass(const float* padded, float* output, int width, const float* kernel, int taps) {
+		int x = 0;
+#ifdef SSC_X86_SIMD
+		if(CpuFeatures::hasAvx2()){
+			x = horizontalPassAvx2(padded, output, width, kernel, taps);
+		}
+#endif
+		for(; x < width; x++){
+			float sum = 0.0f;
+			for(int k = 0; k < taps; k++){
+				sum += kernel[k] * padded[x + k];
+			}
+			output[x] = sum;
+		}
+	}
+
+	void verticalPass(const float* const* rows, float* output, int width, const float* kernel, int taps) {
+		int x = 0;
+#ifdef SSC_X86_SIMD
+		if(CpuFeatures::hasAvx2()){
+			x = verticalPassAvx2(rows, output, width, kernel, taps);
+		}
+#endif
+		for(; x < width; x++){
+			float sum = 0.0f;
+			for(int k = 0; k < taps; k++){
+				sum += kernel[k] * rows[k][x];
+			}
+			output[x] = sum;
+		}
+	}
+
+	void storeRow(const float* input, quint16* output, int width) {
+		int x = 0;
+#ifdef SSC_X86_SIMD
+		if(CpuFeatures::hasAvx2()){
+			x = storeRowAvx2(input, output, width);
+		}
+#endif
+		for(; x < width; x++){
+			output[x] = toSample(input[x]);
+		}
+	}
+
+	void despeckleRow(const float* means, const float* meanSquares, const quint16* input, float* output, int width, float noiseVariance, float& varianceSum) {
+		int x = 0;
+#ifdef SSC_X86_SIMD
+		if(CpuFeatures::hasAvx2()){
+			x = despeckleRowAvx2(means, meanSquares, input, output, width, noiseVariance, varianceSum);
+		}
+#endif
+		for(; x < width; x++){
+			float mean = means[x];
+			float variance = qMax(0.0f, meanSquares[x] - mean * mean);
+			float weight = variance > noiseVariance ? (variance - noiseVariance) / variance : 0.0f;
+			output[x] = mean + weight * (input[x] - mean);
+			varianceSum += variance;
+		}
+	}
+
+	//horizontal pass for the rows of the tile and its halo, the vertical pass reads them from the cache
+	void horizontalTile(const quint16* input, int width, int height, int firstRow, int rowCount, const float* kernel, int radius, bool squared) {
+		int taps = 2 * radius + 1;
+		int rows = rowCount + 2 * radius;
+		scratch.padded.resize(width + 2 * radius);
+		scratch.horizontal.resize(rows * width);
+		if(squared){
+			scratch.paddedSquared.resize(width + 2 * radius);
+			scratch.horizontalSquared.resize(rows * width);
+		}
+		for(int i = 0; i < rows; i++){
+			const quint16* row = input + static_cast<qint64>(clampIndex(firstRow - radius + i, height)) * width;
+			loadPaddedRow(row, scratch.padded.data(), width, radius);
+			horizontalPass(scratch.padded.constData(), scratch.horizontal.data() + i * width, width, kernel, taps);
+			if(squared){
+				square(scratch.padded.constData(), scratch.paddedSquared.data(), width + 2 * radius);
+				horizontalPass(scratch.paddedSquared.constData(), scratch.horizontalSquared.data() + i * width, width, kernel, taps);
+			}
+		}
+	}
+
+	void convolveTile(const quint16* input, quint16* output, int width, int height, int firstRow, int rowCount, const float* kernel, int radius) {
+		int taps = 2 * radius + 1;
+		horizontalTile(input, width, height, firstRow, rowCount, kernel, radius, false);
+		scratch.line.resize(width);
+		QVarLengthArray<const float*, 32> rows(taps);
+		for(int y = 0; y < rowCount; y++){
+			for(int k = 0; k < taps; k++){
+				rows[k] = scratch.horizontal.constData() + (y + k) * width;
+			}
+			verticalPass(rows.constData(), scratch.line.data(), width, kernel, taps);
+			storeRow(scratch.line.constData(), output + static_cast<qint64>(firstRow + y) * width, width);
+		}
+	}
+
+	//Lee filter: the local mean is weighted against the sample by how much the local variance exceeds the noise variance
+	double despeckleTile(const quint16* input, quint16* output, int width, int height, int firstRow, int rowCount, float noiseVariance) {
+		const int radius = DESPECKLE_RADIUS;
+		const int taps = 2 * radius + 1;
+		float kernel[taps];
+		for(int k = 0; k < taps; k++){
+			kernel[k] = 1.0f / taps;
+		}
+		horizontalTile(input, width, height, firstRow, rowCount, kernel, radius, true);
+		scratch.mean.resize(width);
+		scratch.meanSquared.resize(width);
+		scratch.line.resize(width);
+		const float* rows[taps];
+		const float* squaredRows[taps];
+		double varianceSum = 0.0;
+		for(int y = 0; y < rowCount; y++){
+			for(int k = 0; k < taps; k++){
+				rows[k] = scratch.horizontal.constData() + (y + k) * width;
+				squaredRows[k] = scratch.horizontalSquared.constData() + (y + k) * width;
+			}
+			verticalPass(rows, scratch.mean.data(), width, kernel, taps);
+			verticalPass(squaredRows, scratch.meanSquared.data(), width, kernel, taps);
+			const quint16* inputRow = input + static_cast<qint64>(firstRow + y) * width;
+			float rowVarianceSum = 0.0f;
+			despeckleRow(scratch.mean.constData(), scratch.meanSquared.constData(), inputRow, scratch.line.data(), width, noiseVariance, rowVarianceSum);
+			varianceSum += rowVarianceSum;
+			storeRow(scratch.line.constData(), output + static_cast<qint64>(firstRow + y) * width, width);
+		}
+		return varianceSum;
+	}
+
+	//Forgetful selection: of more than half of the samples the minimum and the maximum can not be the median. They are dropped and the next sample is added until all samples were seen, the median of the last three is the result.
+	template<int N>
+	quint16 medianOf(const quint16* samples) {
+		const int kept = N / 2 + 2;
+		quint16 set[kept];
+		for(int i = 0; i < kept; i++){
+			set[i] = samples[i];
+		}
+		int size = kept;
+		for(int next = kept; next < N; next++){
+			for(int i = 1; i < size; i++){
+				quint16 low = qMin(set[0], set[i]);
+				set[i] = qMax(set[0], set[i]);
+				set[0] = low;
+			}
+			for(int i = 1; i < size - 1; i++){
+				quint16 high = qMax(set[i], set[size - 1]);
+				set[i] = qMin(set[i], set[size - 1]);
+				set[size - 1] = high;
+			}
+			set[0] = samples[next];
+			size--;
+		}
+		return qMax(qMin(set[0], set[1]), qMin(qMax(set[0], set[1]), set[2]));
+	}
+
+	template<int RADIUS>
+	quint16 medianAt(const quint16* const* rows, int x, int width) {
+		const int size = 2 * RADIUS + 1;
+		quint16 samples[size * size];
+		for(int dy = 0; dy < size; dy++){
+			for(int dx = 0; dx < size; dx++){
+				samples[dy * size + dx] = rows[dy][clampIndex(x + dx - RADIUS, width)];
+			}
+		}
+		return medianOf<size * size>(samples);
+	}
+
+#ifdef SSC_X86_SIMD
+	//same selection as medianOf() for 16 pixels at once
+	template<int N>
+	SSC_TARGET_AVX2 __m256i medianOfAvx2(const __m256i* samples) {
+		const int kept = N / 2 + 2;
+		__m256i set[kept];
+		for(int i = 0; i < kept; i++){
+			set[i] = samples[i];
+		}
+		int size = kept;
+		for(int next = kept; next < N; next++){
+			for(int i = 1; i < size; i++){
+				__m256i low = _mm256_min_epu16(set[0], set[i]);
+				set[i] = _mm256_max_epu16(set[0], set[i]);
+				set[0] = low;
+			}
+			for(int i = 1; i < size - 1; i++){
+				__m256i high = _mm256_max_epu16(set[i], set[size - 1]);
+				set[i] = _mm256_min_epu16(set[i], set[size - 1]);
+				set[size - 1] = high;
+			}
+			set[0] = samples[next];
+			size--;
+		}
+		return _mm256_max_epu16(_mm256_min_epu16(set[0], set[1]), _mm256_min_epu16(_mm256_max_epu16(set[0], set[1]), set[2]));
+	}
+
+	template<int RADIUS>
+	SSC_TARGET_AVX2 int medianRowAvx2(const quint16* const* rows, quint16* output, int width) {
+		const int size = 2 * RADIUS + 1;
+		int x = RADIUS;
+		for(; x + 16 + RADIUS <= width; x += 16){
+			__m256i samples[size * size];
+			for(int dy = 0; dy < size; dy++){
+				for(int dx = 0; dx < size; dx++){
+					samples[dy * size + dx] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[dy] + x + dx - RADIUS));
+				}
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + x), medianOfAvx2<size * size>(samples));
+		}
+		return x;
+	}
+#endif
+
+	template<int RADIUS>
+	void medianTile(const quint16* input, quint16* output, int width, int height, int firstRow, int rowCount) {
+		const int size = 2 * RADIUS + 1;
+		const quint16* rows[size];
+		for(int y = firstRow; y < firstRow + rowCount; y++){
+			for(int dy = 0; dy < size; dy++){
+				rows[dy] = input + static_cast<qint64>(clampIndex(y + dy - RADIUS, height)) * width;
+			}
+			quint16* outputRow = output + static_cast<qint64>(y) * width;
+			int x = 0;
+			int vectorEnd = 0;
+#ifdef SSC_X86_SIMD
+			if(CpuFeatures::hasAvx2() && width >= 16 + 2 * RADIUS){
+				//the columns at the edges need clamped indices and are done by the scalar code
+				for(; x < RADIUS; x++){
+					outputRow[x] = medianAt<RADIUS>(rows, x, width);
+				}
+				vectorEnd = medianRowAvx2<RADIUS>(rows, outputRow, width);
+				x = vectorEnd;
+			}
+#endif
+			Q_UNUSED(vectorEnd)
+			for(; x < width; x++){
+				outputRow[x] = medianAt<RADIUS>(rows, x, width);
+			}
+		}
+	}
+}
+
+
+SpatialFilter::SpatialFilter()
+{
+	this->currentType = None;
+	this->radius = 0;
+	this->noiseVariance = 0.0f;
+}
+
+void SpatialFilter::setType(Type type) {
+	this->currentType = type;
+	this->noiseVariance = 0.0f;
+	if(type == Gaussian1){
+		this->createGaussianKernel(1.0);
+	}else if(type == Gaussian2){
+		this->createGaussianKernel(2.0);
+	}
+}
+
+void SpatialFilter::createGaussianKernel(double sigma) {
+	this->radius = qCeil(3.0 * sigma);
+	this->kernel.resize(2 * this->radius + 1);
+	double sum = 0.0;
+	for(int i = -this->radius; i <= this->radius; i++){
+		sum += qExp(-(i * i) / (2.0 * sigma * sigma));
+	}
+	for(int i = -this->radius; i <= this->radius; i++){
+		this->kernel[i + this->radius] = static_cast<float>(qExp(-(i * i) / (2.0 * sigma * sigma)) / sum);
+	}
+}
+
+void SpatialFilter::apply(const quint16* input, quint16* output, int width, int height, WorkerPool& pool, const std::function<void(int, int)>& rowsFiltered) {
+	if(width <= 0 || height <= 0){
+		return;
+	}
+	int tiles = (height + FILTER_TILE_ROWS - 1) / FILTER_TILE_ROWS;
+	QVector<double> varianceSums(tiles, 0.0);
+	Type type = this->currentType;
+	const float* kernel = this->kernel.constData();
+	int radius = this->radius;
+	float noiseVariance = this->noiseVariance;
+
+	pool.run(tiles, [&](int tile) {
+		int firstRow = tile * FILTER_TILE_ROWS;
+		int rowCount = qMin(FILTER_TILE_ROWS, height - firstRow);
+		switch(type){
+		case None:
+			memcpy(output + static_cast<qint64>(firstRow) * width, input + static_cast<qint64>(firstRow) * width, static_cast<size_t>(rowCount) * width * sizeof(quint16));
+			break;
+		case Gaussian1:
+		case Gaussian2:
+			convolveTile(input, output, width, height, firstRow, rowCount, kernel, radius);
+			break;
+		case Median3x3:
+			medianTile<1>(input, output, width, height, firstRow, rowCount);
+			break;
+		case Median5x5:
+			medianTile<2>(input, output, width, height, firstRow, rowCount);
+			break;
+		case Despeckle:
+			varianceSums[tile] = despeckleTile(input, output, width, height, firstRow, rowCount, noiseVariance);
+			break;
+		}
+		if(rowsFiltered){
+			rowsFiltered(firstRow, rowCount);
+		}
+	});
+
+	//the noise estimate of this image is used for the next one, which avoids a second pass over the image
+	if(type == Despeckle){
+		double varianceSum = 0.0;
+		for(double sum : varianceSums){
+			varianceSum += sum;
+		}
+		this->noiseVariance = static_cast<float>(varianceSum / (static_cast<double>(width) * height));
+	}
+}
+
+QStringList SpatialFilter::names() {
+	return QStringList() << "Off" << "Gaussian (sigma 1)" << "Gaussian (sigma 2)" << "Median 3x3" << "Median 5x5" << "Despeckle (Lee 5x5)";
+}
@@ -0,0 +1,69 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+
+#ifndef SPATIALFILTER_H
+#define SPATIALFILTER_H
+
+#define FILTER_TILE_ROWS 32 //rows per tile, the float rows of a tile and its halo stay in the L2 cache
+
+#include <functional>
+#include <QVector>
+#include <QStringList>
+#include "workerpool.h"
+
+//Optional display-side filter for 16 bit images (normalized colormap indices). Images are split into tiles of FILTER_TILE_ROWS rows that are filtered in parallel, each tile reads the rows it needs around it from the input, so tiles do not depend on each other. Kernels use AVX2 if available.
+class SpatialFilter
+{
+public:
+	enum Type {
+		None,
+		Gaussian1,
+		Gaussian2,
+		Median3x3,
+		Median5x5,
+		Despeckle
+	};
+
+	SpatialFilter();
+
+	void setType(Type type);
+	Type type() const { return this->currentType; }
+	//rowsFiltered(firstRow, rowCount) is called by the thread that filtered these rows, it can continue to work on them while they are still in the cache
+	void apply(const quint16* input, quint16* output, int width, int height, WorkerPool& pool, const std::function<void(int, int)>& rowsFiltered = std::function<void(int, int)>());
+
+	static QStringList names();
+
+private:
+	void createGaussianKernel(double sigma);
+
+	Type currentType;
+	QVector<float> kernel;
+	int radius;
+	float noiseVariance; //despeckle: mean local variance of the previous image
+};
+
+#endif // SPATIALFILTER_H
@@ -0,0 +1,184 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "streamheader.h"
+#include <QDataStream>
+
+namespace {
+	QByteArray identifierBytes(quint32 identifier) {
+		//identifiers are sent in network byte order
+		QByteArray bytes(4, 0);
+		bytes[0] = static_cast<char>((identifier >> 24) & 0xFF);
+		bytes[1] = static_cast<char>((identifier >> 16) & 0xFF);
+		bytes[2] = static_cast<char>((identifier >> 8) & 0xFF);
+		bytes[3] = static_cast<char>(identifier & 0xFF);
+		return bytes;
+	}
+}
+
+
+bool StreamHeader::parse(const QByteArray& data) {
+	if(data.size() < SIZE){
+		return false;
+	}
+	QDataStream headerStream(data);
+	headerStream.setByteOrder(QDataStream::BigEndian);
+	headerStream >> this->startIdentifier;
+
+	if(this->startIdentifier != EXTENDED_MAGIC_NUMBER){
+		this->version = 1;
+		this->headerSize = SIZE;
+		this->sequenceNumber = 0;
+		this->senderTimestampUs = 0;
+		this->sampleFormat = static_cast<quint8>(SampleFormat::Unsigned);
+		this->flags = 0;
+		this->payloadChecksum = 0;
+		headerStream >> this->bufferSizeInBytes >> this->frameWidth >> this->frameHeight >> this->bitDepth;
+		this->setFullRegion();
+		return true;
+	}
+
+	headerStream >> this->version >> this->headerSize;
+	if(this->version < 2 || this->headerSize < EXTENDED_SIZE || this->headerSize > MAX_HEADER_SIZE || data.size() < this->headerSize){
+		this->version = 0; //marks header as invalid
+		return false;
+	}
+	headerStream >> this->bufferSizeInBytes >> this->frameWidth >> this->frameHeight >> this->bitDepth;
+	headerStream >> this->sequenceNumber >> this->senderTimestampUs;
+	this->sampleFormat = static_cast<quint8>(SampleFormat::Unsigned);
+	if(this->version >= 3 && this->headerSize >= VERSION_3_SIZE){
+		headerStream >> this->sampleFormat;
+	}
+	this->flags = 0;
+	this->payloadChecksum = 0;
+	if(this->version >= 4 && this->headerSize >= VERSION_4_SIZE){
+		headerStream >> this->flags >> this->payloadChecksum;
+	}
+	this->setFullRegion();
+	if(this->version >= 5 && this->headerSize >= VERSION_5_SIZE){
+		headerStream >> this->regionX >> this->regionY >> this->fullWidth >> this->fullHeight >> this->sampleStep >> this->lineStep >> this->frameStep;
+		//a region that does not fit into the full frame is displayed as full frame
+		if(this->sampleStep == 0 || this->lineStep == 0 || this->frameStep == 0 || this->regionX + (this->frameWidth - 1) * this->sampleStep >= this->fullWidth || this->regionY + (this->frameHeight - 1) * this->lineStep >= this->fullHeight){
+			this->setFullRegion();
+		}
+	}
+	return true;
+}
+
+void StreamHeader::setFullRegion() {
+	this->regionX = 0;
+	this->regionY = 0;
+	this->fullWidth = this->frameWidth;
+	this->fullHeight = this->frameHeight;
+	this->sampleStep = 1;
+	this->lineStep = 1;
+	this->frameStep = 1;
+}
+
+QByteArray StreamHeader::toByteArray() const {
+	QByteArray data;
+	QDataStream headerStream(&data, QIODevice::WriteOnly);
+	headerStream.setByteOrder(QDataStream::BigEndian);
+	if(!this->isExtended()){
+		headerStream << MAGIC_NUMBER << this->bufferSizeInBytes << this->frameWidth << this->frameHeight << this->bitDepth;
+		return data;
+	}
+	quint16 size = static_cast<quint16>(EXTENDED_SIZE);
+	if(this->version >= 5){
+		size = static_cast<quint16>(VERSION_5_SIZE);
+	}else if(this->version == 4){
+		size = static_cast<quint16>(VERSION_4_SIZE);
+	}else if(this->version == 3){
+		size = static_cast<quint16>(VERSION_3_SIZE);
+	}
+	headerStream << EXTENDED_MAGIC_NUMBER << this->version << size;
+	headerStream << this->bufferSizeInBytes << this->frameWidth << this->frameHeight << this->bitDepth;
+	headerStream << this->sequenceNumber << this->senderTimestampUs;
+	if(this->version >= 3){
+		headerStream << this->sampleFormat;
+	}
+	if(this->version >= 4){
+		headerStream << this->flags << this->payloadChecksum;
+	}
+	if(this->version >= 5){
+		headerStream << this->regionX << this->regionY << this->fullWidth << this->fullHeight << this->sampleStep << this->lineStep << this->frameStep;
+	}
+	return data;
+}
+
+bool StreamHeader::hasValidIdentifier() const {
+	return this->startIdentifier == MAGIC_NUMBER || (this->startIdentifier == EXTENDED_MAGIC_NUMBER && this->version >= 2);
+}
+
+bool StreamHeader::hasValidSize() const {
+	return this->bufferSizeInBytes > 0 && this->bufferSizeInBytes < MAX_ALLOWED_SIZE;
+}
+
+bool StreamHeader::hasValidSampleFormat() const {
+	return isValidSampleFormat(this->bitDepth, static_cast<SampleFormat>(this->sampleFormat));
+}
+
+bool StreamHeader::isValidSampleFormat(int bitDepth, SampleFormat format) {
+	//samples are stored in 1, 2 or 4 bytes, there is no 3 byte sample size
+	if(bitDepth > 16 && bitDepth <= 24){
+		return false;
+	}
+	switch(format){
+	case SampleFormat::Unsigned:
+		return bitDepth > 0 && bitDepth <= 32;
+	case SampleFormat::Signed:
+		return bitDepth > 1 && bitDepth <= 32;
+	case SampleFormat::Float:
+		return bitDepth == 32;
+	}
+	return false;
+}
+
+int StreamHeader::sizeOf(const QByteArray& data) {
+	//the first SIZE bytes always contain enough information to determine the full header size
+	if(data.size() < SIZE){
+		return SIZE;
+	}
+	QDataStream headerStream(data);
+	headerStream.setByteOrder(QDataStream::BigEndian);
+	quint32 identifier;
+	quint8 version;
+	quint16 headerSize;
+	headerStream >> identifier >> version >> headerSize;
+	if(identifier != EXTENDED_MAGIC_NUMBER || headerSize < EXTENDED_SIZE || headerSize > MAX_HEADER_SIZE){
+		return SIZE;
+	}
+	return headerSize;
+}
+
+int StreamHeader::indexOfMagicNumber(const QByteArray& data, int from) {
+	int index = data.indexOf(identifierBytes(MAGIC_NUMBER), from);
+	int extendedIndex = data.indexOf(identifierBytes(EXTENDED_MAGIC_NUMBER), from);
+	if(index == -1 || (extendedIndex != -1 && extendedIndex < index)){
+		return extendedIndex;
+	}
+	return index;
+}
@@ -0,0 +1,85 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef STREAMHEADER_H
+#define STREAMHEADER_H
+
+#include <QByteArray>
+#include "frame.h"
+
+//header that SocketStreamExtension sends in front of every buffer (all fields big endian)
+//version 1: startIdentifier, bufferSizeInBytes, frameWidth, frameHeight, bitDepth
+//version 2 and later: extendedStartIdentifier, version, headerSize, the version 1 fields, sequenceNumber, senderTimestampUs
+//version 3 and later: the version 2 fields, sampleFormat
+//version 4 and later: the version 3 fields, flags, payloadChecksum (CRC-32C of the payload, only valid if FLAG_PAYLOAD_CHECKSUM is set)
+//version 5 and later: the version 4 fields, regionX, regionY, fullWidth, fullHeight, sampleStep, lineStep, frameStep. They describe which part of the full frame the payload contains if the client sent a StreamRequest. Fields added by later versions are appended, unknown trailing bytes are skipped by using headerSize.
+struct StreamHeader {
+	static const quint32 MAGIC_NUMBER = 299792458; // used as startIdentifier
+	static const quint32 EXTENDED_MAGIC_NUMBER = 0x4F43545A; // "OCTZ", used as startIdentifier of versioned headers
+	static const int SIZE = 4 + 4 + 2 + 2 + 1; // startIdentifier + bufferSizeInBytes + frameWidth + frameHeight + bitDepth
+	static const int EXTENDED_SIZE = 4 + 1 + 2 + 4 + 2 + 2 + 1 + 8 + 8; // extendedStartIdentifier + version + headerSize + version 1 fields + sequenceNumber + senderTimestampUs
+	static const int VERSION_3_SIZE = EXTENDED_SIZE + 1; // version 2 fields + sampleFormat
+	static const int VERSION_4_SIZE = VERSION_3_SIZE + 1 + 4; // version 3 fields + flags + payloadChecksum
+	static const int VERSION_5_SIZE = VERSION_4_SIZE + 2 + 2 + 2 + 2 + 1 + 1 + 1; // version 4 fields + regionX + regionY + fullWidth + fullHeight + sampleStep + lineStep + frameStep
+	static const int MAX_HEADER_SIZE = 1024;
+	static const quint32 MAX_ALLOWED_SIZE = 4 * 4096 * 4096 * 8;
+	static const quint8 FLAG_PAYLOAD_CHECKSUM = 0x01;
+
+	quint32 startIdentifier;
+	quint8 version;
+	quint16 headerSize;
+	quint32 bufferSizeInBytes;
+	quint16 frameWidth;
+	quint16 frameHeight;
+	quint8 bitDepth;
+	quint64 sequenceNumber;
+	qint64 senderTimestampUs;
+	quint8 sampleFormat; // see SampleFormat in frame.h, unsigned for headers below version 3
+	quint8 flags;
+	quint32 payloadChecksum;
+	quint16 regionX; // first sample of the region in the full frame
+	quint16 regionY; // first line of the region in the full frame
+	quint16 fullWidth; // frame size without region and decimation, equal to frameWidth and frameHeight below version 5
+	quint16 fullHeight;
+	quint8 sampleStep; // every sampleStep-th sample and lineStep-th line of the region is sent
+	quint8 lineStep;
+	quint8 frameStep; // every frameStep-th frame of the buffer is sent
+
+	bool parse(const QByteArray& data);
+	QByteArray toByteArray() const;
+	bool hasValidIdentifier() const;
+	bool hasValidSize() const;
+	bool hasValidSampleFormat() const;
+	static bool isValidSampleFormat(int bitDepth, SampleFormat format);
+	bool isExtended() const { return this->version >= 2; }
+	bool hasPayloadChecksum() const { return (this->flags & FLAG_PAYLOAD_CHECKSUM) != 0; }
+	void setFullRegion();
+
+	static int sizeOf(const QByteArray& data);
+	static int indexOfMagicNumber(const QByteArray& data, int from = 0);
+};
+
+#endif // STREAMHEADER_H
@@ -0,0 +1,98 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+
+#include "streamrequest.h"
+#include <QList>
+
+const char* const StreamRequest::COMMAND = "remote_request";
+
+
+StreamRequest::StreamRequest()
+{
+	this->x = 0;
+	this->y = 0;
+	this->width = 0;
+	this->height = 0;
+	this->sampleStep = 1;
+	this->lineStep = 1;
+	this->frameStep = 1;
+}
+
+bool StreamRequest::parse(const QByteArray& line) {
+	QList<QByteArray> fields = line.trimmed().split(' ');
+	if(fields.isEmpty() || fields.first() != COMMAND){
+		return false;
+	}
+	*this = StreamRequest();
+	for(int i = 1; i < fields.size(); i++){
+		int separator = fields.at(i).indexOf('=');
+		if(separator <= 0){
+			continue;
+		}
+		QByteArray key = fields.at(i).left(separator);
+		bool ok = false;
+		uint value = fields.at(i).mid(separator + 1).toUInt(&ok);
+		if(!ok){
+			return false;
+		}
+		quint16 position = static_cast<quint16>(qMin(value, 65535u));
+		quint8 step = static_cast<quint8>(qBound(1u, value, static_cast<uint>(MAX_STEP)));
+		if(key == "x"){
+			this->x = position;
+		}else if(key == "y"){
+			this->y = position;
+		}else if(key == "width"){
+			this->width = position;
+		}else if(key == "height"){
+			this->height = position;
+		}else if(key == "sample_step"){
+			this->sampleStep = step;
+		}else if(key == "line_step"){
+			this->lineStep = step;
+		}else if(key == "frame_step"){
+			this->frameStep = step;
+		}
+	}
+	return true;
+}
+
+QByteArray StreamRequest::toByteArray() const {
+	return QByteArray(COMMAND)
+			+ " x=" + QByteArray::number(this->x) + " y=" + QByteArray::number(this->y)
+			+ " width=" + QByteArray::number(this->width) + " height=" + QByteArray::number(this->height)
+			+ " sample_step=" + QByteArray::number(this->sampleStep) + " line_step=" + QByteArray::number(this->lineStep)
+			+ " frame_step=" + QByteArray::number(this->frameStep) + "\n";
+}
+
+bool StreamRequest::isFullFrame() const {
+	return this->x == 0 && this->y == 0 && this->width == 0 && this->height == 0 && this->sampleStep == 1 && this->lineStep == 1 && this->frameStep == 1;
+}
+
+bool StreamRequest::operator==(const StreamRequest& other) const {
+	return this->x == other.x && this->y == other.y && this->width == other.width && this->height == other.height
+			&& this->sampleStep == other.sampleStep && this->lineStep == other.lineStep && this->frameStep == other.frameStep;
+}
@@ -0,0 +1,59 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+
+#ifndef STREAMREQUEST_H
+#define STREAMREQUEST_H
+
+#include <QByteArray>
+#include <QMetaType>
+
+//request the client sends over the remote control channel to reduce what the server sends, one line of text:
+//"remote_request x=<x> y=<y> width=<w> height=<h> sample_step=<n> line_step=<n> frame_step=<n>\n"
+//x, y, width and height select a region of the full frame in samples and lines, a width or height of 0 extends the region to the end of the frame. Of this region every sample_step-th sample and line_step-th line is sent, and every frame_step-th frame of a buffer. Missing keys keep their default (full frame), unknown keys are ignored so fields can be added later.
+struct StreamRequest {
+	static const char* const COMMAND;
+	static const int MAX_STEP = 255;
+
+	quint16 x;
+	quint16 y;
+	quint16 width;
+	quint16 height;
+	quint8 sampleStep;
+	quint8 lineStep;
+	quint8 frameStep;
+
+	StreamRequest();
+
+	bool parse(const QByteArray& line);
+	QByteArray toByteArray() const;
+	bool isFullFrame() const;
+	bool operator==(const StreamRequest& other) const;
+	bool operator!=(const StreamRequest& other) const { return !(*this == other); }
+};
+Q_DECLARE_METATYPE(StreamRequest)
+
+#endif // STREAMREQUEST_H
@@ -0,0 +1,168 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "streamstatistics.h"
+#include <QtMath>
+
+namespace {
+	double standardDeviation(double sum, double squaredSum, quint64 count) {
+		if(count < 2){
+			return 0.0;
+		}
+		double mean = sum / count;
+		return qSqrt(qMax(0.0, squaredSum / count - mean * mean));
+	}
+}
+
+
+StreamStatistics::StreamStatistics()
+{
+	this->reset();
+}
+
+void StreamStatistics::reset() {
+	this->receivedCount = 0;
+	this->lostCount = 0;
+	this->reorderedCount = 0;
+	this->duplicatedCount = 0;
+	this->lastSequenceNumber = 0;
+	this->sequenceNumbersAvailable = false;
+	this->checkedCount = 0;
+	this->checksumFailureCount = 0;
+	this->lastReceiveTimestampUs = 0;
+	this->resetLatency();
+}
+
+void StreamStatistics::resetLatency() {
+	this->latencySumUs = 0;
+	this->latencyMinUs = 0;
+	this->latencyMaxUs = 0;
+	this->latencyCount = 0;
+	this->latencySquaredSumUs = 0.0;
+	this->intervalSumUs = 0;
+	this->intervalMaxUs = 0;
+	this->intervalCount = 0;
+	this->intervalSquaredSumUs = 0.0;
+}
+
+void StreamStatistics::addFrame(const FrameInfo& info) {
+	this->receivedCount++;
+
+	if(info.hasSequenceNumber){
+		quint64 sequenceNumber = info.sequenceNumber;
+		if(!this->sequenceNumbersAvailable){
+			this->sequenceNumbersAvailable = true;
+			this->lastSequenceNumber = sequenceNumber;
+		}else if(sequenceNumber > this->lastSequenceNumber){
+			this->lostCount += sequenceNumber - this->lastSequenceNumber - 1;
+			this->lastSequenceNumber = sequenceNumber;
+		}else if(sequenceNumber == this->lastSequenceNumber){
+			this->duplicatedCount++;
+		}else{
+			//a late frame that has already been counted as lost
+			this->reorderedCount++;
+			if(this->lostCount > 0){
+				this->lostCount--;
+			}
+		}
+	}
+
+	if(info.checksumState != ChecksumState::None){
+		this->checkedCount++;
+		if(info.checksumState == ChecksumState::Invalid){
+			this->checksumFailureCount++;
+		}
+	}
+
+	if(info.senderTimestampUs > 0 && info.receiveTimestampUs > 0){
+		qint64 latencyUs = info.receiveTimestampUs - info.senderTimestampUs;
+		if(this->latencyCount == 0 || latencyUs < this->latencyMinUs){
+			this->latencyMinUs = latencyUs;
+		}
+		if(this->latencyCount == 0 || latencyUs > this->latencyMaxUs){
+			this->latencyMaxUs = latencyUs;
+		}
+		this->latencySumUs += latencyUs;
+		this->latencySquaredSumUs += static_cast<double>(latencyUs) * latencyUs;
+		this->latencyCount++;
+	}
+
+	if(info.receiveTimestampUs > 0){
+		if(this->lastReceiveTimestampUs > 0){
+			qint64 intervalUs = info.receiveTimestampUs - this->lastReceiveTimestampUs;
+			this->intervalMaxUs = qMax(this->intervalMaxUs, intervalUs);
+			this->intervalSumUs += intervalUs;
+			this->intervalSquaredSumUs += static_cast<double>(intervalUs) * intervalUs;
+			this->intervalCount++;
+		}
+		this->lastReceiveTimestampUs = info.receiveTimestampUs;
+	}
+}
+
+double StreamStatistics::meanLatencyMs() const {
+	return this->latencyCount > 0 ? static_cast<double>(this->latencySumUs) / this->latencyCount / 1000.0 : 0.0;
+}
+
+double StreamStatistics::minLatencyMs() const {
+	return this->latencyMinUs / 1000.0;
+}
+
+double StreamStatistics::maxLatencyMs() const {
+	return this->latencyMaxUs / 1000.0;
+}
+
+double StreamStatistics::latencyJitterMs() const {
+	return standardDeviation(static_cast<double>(this->latencySumUs), this->latencySquaredSumUs, this->latencyCount) / 1000.0;
+}
+
+double StreamStatistics::meanArrivalIntervalMs() const {
+	return this->intervalCount > 0 ? static_cast<double>(this->intervalSumUs) / this->intervalCount / 1000.0 : 0.0;
+}
+
+double StreamStatistics::arrivalJitterMs() const {
+	return standardDeviation(static_cast<double>(this->intervalSumUs), this->intervalSquaredSumUs, this->intervalCount) / 1000.0;
+}
+
+double StreamStatistics::maxArrivalIntervalMs() const {
+	return this->intervalMaxUs / 1000.0;
+}
+
+QString StreamStatistics::toString() const {
+	QString text = QString("Frames: %1").arg(this->receivedCount);
+	if(this->sequenceNumbersAvailable){
+		text += QString("  Lost: %1  Reordered: %2").arg(this->lostCount).arg(this->reorderedCount);
+	}
+	if(this->checkedCount > 0){
+		text += QString("  Checksum errors: %1").arg(this->checksumFailureCount);
+	}
+	if(this->latencyCount > 0){
+		text += QString("  Latency: %1 ms (%2 - %3, jitter %4)").arg(this->meanLatencyMs(), 0, 'f', 2).arg(this->minLatencyMs(), 0, 'f', 2).arg(this->maxLatencyMs(), 0, 'f', 2).arg(this->latencyJitterMs(), 0, 'f', 2);
+	}
+	if(this->intervalCount > 0){
+		text += QString("  Arrival interval: %1 ms (jitter %2, max %3)").arg(this->meanArrivalIntervalMs(), 0, 'f', 2).arg(this->arrivalJitterMs(), 0, 'f', 2).arg(this->maxArrivalIntervalMs(), 0, 'f', 2);
+	}
+	return text;
+}
@@ -0,0 +1,87 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef STREAMSTATISTICS_H
+#define STREAMSTATISTICS_H
+
+#include <QMetaType>
+#include <QString>
+#include "frame.h"
+
+//keeps track of lost and reordered frames (via header sequence numbers), of payload checksum failures, of the latency between sender and receiver timestamps and of the jitter (standard deviation) of latency and frame arrival intervals
+class StreamStatistics
+{
+public:
+	StreamStatistics();
+
+	void reset();
+	void resetLatency();
+	void addFrame(const FrameInfo& info);
+
+	quint64 framesReceived() const { return this->receivedCount; }
+	quint64 framesLost() const { return this->lostCount; }
+	quint64 framesReordered() const { return this->reorderedCount; }
+	quint64 framesDuplicated() const { return this->duplicatedCount; }
+	bool hasSequenceNumbers() const { return this->sequenceNumbersAvailable; }
+	bool hasChecksums() const { return this->checkedCount > 0; }
+	quint64 framesChecked() const { return this->checkedCount; }
+	quint64 checksumFailures() const { return this->checksumFailureCount; }
+	bool hasLatency() const { return this->latencyCount > 0; }
+	double meanLatencyMs() const;
+	double minLatencyMs() const;
+	double maxLatencyMs() const;
+	double latencyJitterMs() const;
+	bool hasArrivalIntervals() const { return this->intervalCount > 0; }
+	double meanArrivalIntervalMs() const;
+	double arrivalJitterMs() const;
+	double maxArrivalIntervalMs() const;
+	QString toString() const;
+
+private:
+	quint64 receivedCount;
+	quint64 lostCount;
+	quint64 reorderedCount;
+	quint64 duplicatedCount;
+	quint64 lastSequenceNumber;
+	bool sequenceNumbersAvailable;
+	quint64 checkedCount;
+	quint64 checksumFailureCount;
+
+	qint64 latencySumUs;
+	qint64 latencyMinUs;
+	qint64 latencyMaxUs;
+	quint64 latencyCount;
+	double latencySquaredSumUs;
+
+	qint64 lastReceiveTimestampUs;
+	qint64 intervalSumUs;
+	qint64 intervalMaxUs;
+	quint64 intervalCount;
+	double intervalSquaredSumUs;
+};
+Q_DECLARE_METATYPE(StreamStatistics)
+
+#endif // STREAMSTATISTICS_H
@@ -0,0 +1,299 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "testserver.h"
+#include "streamheader.h"
+#include "receivetimestamp.h"
+#include "crc32c.h"
+#include <QtMath>
+#include <climits>
+
+#define MAX_PENDING_BUFFERS 4 //buffers are dropped (and the sequence number skipped) if a client does not keep up
+#define MAX_COMMAND_LENGTH 1024
+#define COMMAND_PREFIX "remote_"
+#define START_COMMAND "remote_start"
+#define STOP_COMMAND "remote_stop"
+
+namespace {
+	//true if data is the beginning of a command whose remaining bytes have not been received yet
+	bool isIncompleteCommand(const QByteArray& data) {
+		return QByteArray(START_COMMAND).startsWith(data) || QByteArray(STOP_COMMAND).startsWith(data) || QByteArray(StreamRequest::COMMAND).startsWith(data);
+	}
+}
+
+
+TestServer::TestServer(QObject *parent) : QObject(parent)
+{
+	this->server = new QTcpServer(this);
+	this->sendTimer = new QTimer(this);
+	this->sendTimer->setTimerType(Qt::PreciseTimer);
+	this->sequenceNumber = 0;
+	this->payload.checksum = 0;
+
+	this->params.bitDepth = 16;
+	this->params.sampleFormat = SampleFormat::Unsigned;
+	this->params.samplesPerLine = 1024;
+	this->params.linesPerFrame = 512;
+	this->params.framesPerBuffer = 4;
+	this->params.buffersPerSecond = 50;
+	this->params.autoStart = true;
+	this->params.corruptEvery = 0;
+
+	connect(this->server, &QTcpServer::newConnection, this, &TestServer::onNewConnection);
+	connect(this->sendTimer, &QTimer::timeout, this, &TestServer::sendBuffer);
+}
+
+bool TestServer::listen(quint16 port) {
+	if(!this->server->listen(QHostAddress::LocalHost, port)){
+		emit info(tr("TestServer: Could not listen on port %1: %2").arg(port).arg(this->server->errorString()));
+		return false;
+	}
+	this->serverPort.storeRelease(this->server->serverPort());
+	return true;
+}
+
+void TestServer::setParams(TestServerParameters params) {
+	this->params = params;
+	this->payload.data.clear();
+	this->requestedPayloads.clear();
+	if(this->sendTimer->isActive()){
+		this->startStreaming();
+	}
+}
+
+void TestServer::startStreaming() {
+	if(this->payload.data.isEmpty()){
+		this->createPayload();
+	}
+	this->sendTimer->start(qMax(1, 1000 / qMax(1, this->params.buffersPerSecond)));
+}
+
+void TestServer::stopStreaming() {
+	this->sendTimer->stop();
+}
+
+void TestServer::createPayload() {
+	//diagonal gradient that covers the full range of the bit depth, signed and float samples range from negative to positive values
+	int bytesPerSample = qCeil(static_cast<double>(this->params.bitDepth) / 8.0);
+	int samplesPerFrame = this->params.samplesPerLine * this->params.linesPerFrame;
+	int samplesPerBuffer = samplesPerFrame * this->params.framesPerBuffer;
+	quint64 maxValue = (static_cast<quint64>(1) << this->params.bitDepth) - 1;
+	int period = qMax(1, this->params.samplesPerLine + this->params.linesPerFrame);
+	QByteArray& data = this->payload.data;
+	data.resize(samplesPerBuffer * bytesPerSample);
+	for(int i = 0; i < samplesPerBuffer; i++){
+		int x = i % this->params.samplesPerLine;
+		int y = (i / this->params.samplesPerLine) % this->params.linesPerFrame;
+		quint64 value = maxValue * ((x + y) % period) / period;
+		if(this->params.sampleFormat == SampleFormat::Signed){
+			value = static_cast<quint64>(static_cast<qint64>(value) - static_cast<qint64>(maxValue / 2) - 1);
+		}else if(this->params.sampleFormat == SampleFormat::Float){
+			float floatValue = 2.0f * static_cast<float>((x + y) % period) / period - 1.0f;
+			quint32 bits;
+			memcpy(&bits, &floatValue, sizeof(bits));
+			value = bits;
+		}
+		for(int b = 0; b < bytesPerSample; b++){
+			data[i * bytesPerSample + b] = static_cast<char>((value >> (8 * b)) & 0xFF); //samples are little endian like on the sender side
+		}
+	}
+	this->payload.checksum = Crc32c::compute(data.constData(), static_cast<size_t>(data.size()));
+	this->payload.regionX = 0;
+	this->payload.regionY = 0;
+	this->payload.width = this->params.samplesPerLine;
+	this->payload.height = this->params.linesPerFrame;
+	this->payload.sampleStep = 1;
+	this->payload.lineStep = 1;
+	this->payload.frameStep = 1;
+}
+
+TestServerPayload TestServer::createRequestedPayload(const StreamRequest& request) const {
+	//region is clipped to the full frame, partially covered decimation steps at the end of the region are included
+	int bytesPerSample = qCeil(static_cast<double>(this->params.bitDepth) / 8.0);
+	int fullWidth = this->params.samplesPerLine;
+	int fullHeight = this->params.linesPerFrame;
+	TestServerPayload requested;
+	requested.regionX = qMin(static_cast<int>(request.x), fullWidth - 1);
+	requested.regionY = qMin(static_cast<int>(request.y), fullHeight - 1);
+	int regionWidth = request.width == 0 ? fullWidth - requested.regionX : qMin(static_cast<int>(request.width), fullWidth - requested.regionX);
+	int regionHeight = request.height == 0 ? fullHeight - requested.regionY : qMin(static_cast<int>(request.height), fullHeight - requested.regionY);
+	requested.sampleStep = request.sampleStep;
+	requested.lineStep = request.lineStep;
+	requested.frameStep = request.frameStep;
+	requested.width = (regionWidth + requested.sampleStep - 1) / requested.sampleStep;
+	requested.height = (regionHeight + requested.lineStep - 1) / requested.lineStep;
+	int frames = (this->params.framesPerBuffer + requested.frameStep - 1) / requested.frameStep;
+
+	requested.data.resize(frames * requested.height * requested.width * bytesPerSample);
+	const char* input = this->payload.data.constData();
+	char* output = requested.data.data();
+	for(int f = 0; f < frames; f++){
+		for(int y = 0; y < requested.height; y++){
+			qint64 inputLine = static_cast<qint64>(f * requested.frameStep) * fullHeight + requested.regionY + y * requested.lineStep;
+			const char* inputSample = input + (inputLine * fullWidth + requested.regionX) * bytesPerSample;
+			if(requested.sampleStep == 1){
+				memcpy(output, inputSample, static_cast<size_t>(requested.width * bytesPerSample));
+				output += requested.width * bytesPerSample;
+				continue;
+			}
+			for(int x = 0; x < requested.width; x++){
+				memcpy(output, inputSample + x * requested.sampleStep * bytesPerSample, static_cast<size_t>(bytesPerSample));
+				output += bytesPerSample;
+			}
+		}
+	}
+	requested.checksum = Crc32c::compute(requested.data.constData(), static_cast<size_t>(requested.data.size()));
+	return requested;
+}
+
+const TestServerPayload& TestServer::payloadFor(QTcpSocket* client) {
+	if(!this->requests.contains(client)){
+		return this->payload;
+	}
+	QHash<QTcpSocket*, TestServerPayload>::iterator requested = this->requestedPayloads.find(client);
+	if(requested == this->requestedPayloads.end()){
+		requested = this->requestedPayloads.insert(client, this->createRequestedPayload(this->requests.value(client)));
+	}
+	return requested.value();
+}
+
+QByteArray TestServer::createHeader(const TestServerPayload& payload, quint64 sequenceNumber, qint64 timestampUs) const {
+	StreamHeader header;
+	header.startIdentifier = StreamHeader::EXTENDED_MAGIC_NUMBER;
+	header.version = 5;
+	header.headerSize = StreamHeader::VERSION_5_SIZE;
+	header.bufferSizeInBytes = static_cast<quint32>(payload.data.size());
+	header.frameWidth = static_cast<quint16>(payload.width);
+	header.frameHeight = static_cast<quint16>(payload.height);
+	header.bitDepth = static_cast<quint8>(this->params.bitDepth);
+	header.sampleFormat = static_cast<quint8>(this->params.sampleFormat);
+	header.sequenceNumber = sequenceNumber;
+	header.senderTimestampUs = timestampUs;
+	header.flags = StreamHeader::FLAG_PAYLOAD_CHECKSUM;
+	header.payloadChecksum = payload.checksum;
+	header.regionX = static_cast<quint16>(payload.regionX);
+	header.regionY = static_cast<quint16>(payload.regionY);
+	header.fullWidth = static_cast<quint16>(this->params.samplesPerLine);
+	header.fullHeight = static_cast<quint16>(this->params.linesPerFrame);
+	header.sampleStep = static_cast<quint8>(payload.sampleStep);
+	header.lineStep = static_cast<quint8>(payload.lineStep);
+	header.frameStep = static_cast<quint8>(payload.frameStep);
+	return header.toByteArray();
+}
+
+void TestServer::onNewConnection() {
+	while(this->server->hasPendingConnections()){
+		QTcpSocket* client = this->server->nextPendingConnection();
+		this->clients.append(client);
+		connect(client, &QTcpSocket::readyRead, this, &TestServer::readCommands);
+		connect(client, &QTcpSocket::disconnected, this, [this, client]() {
+			this->clients.removeAll(client);
+			this->requests.remove(client);
+			this->requestedPayloads.remove(client);
+			this->commandBuffers.remove(client);
+			client->deleteLater();
+		});
+	}
+	if(this->params.autoStart && !this->sendTimer->isActive()){
+		this->startStreaming();
+	}
+}
+
+void TestServer::readCommands() {
+	QTcpSocket* client = qobject_cast<QTcpSocket*>(this->sender());
+	if(client == nullptr){
+		return;
+	}
+	//the start and stop commands are not terminated, requests end with a newline. Commands may be split across reads, so everything is collected per client and only complete commands are consumed.
+	QByteArray& pending = this->commandBuffers[client];
+	pending.append(client->readAll());
+	const QByteArray startCommand(START_COMMAND);
+	const QByteArray stopCommand(STOP_COMMAND);
+	while(!pending.isEmpty()){
+		int start = pending.indexOf(COMMAND_PREFIX);
+		if(start < 0){
+			//keep what could be the beginning of the next command prefix
+			pending = pending.right(static_cast<int>(qstrlen(COMMAND_PREFIX)) - 1);
+			break;
+		}
+		pending.remove(0, start);
+		if(pending.startsWith(startCommand)){
+			pending.remove(0, startCommand.size());
+			this->startStreaming();
+		}else if(pending.startsWith(stopCommand)){
+			pending.remove(0, stopCommand.size());
+			this->stopStreaming();
+		}else if(pending.startsWith(StreamRequest::COMMAND)){
+			int end = pending.indexOf('\n');
+			if(end < 0){
+				break;
+			}
+			QByteArray line = pending.left(end);
+			pending.remove(0, end + 1);
+			StreamRequest request;
+			if(request.parse(line)){
+				this->requestedPayloads.remove(client);
+				if(request.isFullFrame()){
+					this->requests.remove(client);
+				}else{
+					this->requests.insert(client, request);
+				}
+			}
+		}else if(isIncompleteCommand(pending)){
+			break;
+		}else{
+			pending.remove(0, 1); //unknown command, continue with the next prefix
+		}
+	}
+	if(pending.size() > MAX_COMMAND_LENGTH){
+		pending.clear();
+	}
+}
+
+void TestServer::sendBuffer() {
+	quint64 sequenceNumber = this->sequenceNumber++;
+	qint64 timestampUs = ReceiveTimestamp::currentTimeUs();
+	bool corrupt = this->params.corruptEvery > 0 && sequenceNumber % static_cast<quint64>(this->params.corruptEvery) == 0;
+
+	qint64 pending = 0;
+	for(QTcpSocket* client : this->clients){
+		const TestServerPayload& payload = this->payloadFor(client);
+		if(client->bytesToWrite() > MAX_PENDING_BUFFERS * static_cast<qint64>(payload.data.size())){
+			pending += client->bytesToWrite();
+			continue;
+		}
+		//the copy is only made for buffers that are deliberately corrupted
+		QByteArray buffer = payload.data;
+		if(corrupt && !buffer.isEmpty()){
+			int index = static_cast<int>(sequenceNumber % static_cast<quint64>(buffer.size()));
+			buffer[index] = static_cast<char>(buffer.at(index) ^ 0x01);
+		}
+		client->write(this->createHeader(payload, sequenceNumber, timestampUs));
+		client->write(buffer);
+		pending += client->bytesToWrite();
+	}
+	this->bytesToWrite.storeRelease(static_cast<int>(qMin(pending, static_cast<qint64>(INT_MAX))));
+}
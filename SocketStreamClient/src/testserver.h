@@ -0,0 +1,108 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef TESTSERVER_H
+#define TESTSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QList>
+#include <QByteArray>
+#include <QAtomicInt>
+#include <QHash>
+#include "frame.h"
+#include "streamrequest.h"
+
+struct TestServerParameters {
+	int bitDepth;
+	SampleFormat sampleFormat;
+	int samplesPerLine;
+	int linesPerFrame;
+	int framesPerBuffer;
+	int buffersPerSecond;
+	bool autoStart;
+	int corruptEvery; //flips a payload byte of every n-th buffer after the checksum has been computed, 0 disables it
+};
+
+//buffer content for one StreamRequest, the full buffer if nothing was requested
+struct TestServerPayload {
+	QByteArray data;
+	quint32 checksum;
+	int regionX;
+	int regionY;
+	int width;
+	int height;
+	int sampleStep;
+	int lineStep;
+	int frameStep;
+};
+
+//Local stand-in for SocketStreamExtension. Sends synthetic buffers with version 5 headers (including a payload checksum) to every connected client and understands the remote control commands. Clients that sent a StreamRequest get only their region, decimation and frame subsample.
+class TestServer : public QObject
+{
+	Q_OBJECT
+public:
+	explicit TestServer(QObject *parent = nullptr);
+
+	quint16 port() const { return static_cast<quint16>(this->serverPort.loadAcquire()); }
+	int pendingBytes() const { return this->bytesToWrite.loadAcquire(); }
+
+private:
+	QTcpServer* server;
+	QTimer* sendTimer;
+	QList<QTcpSocket*> clients;
+	TestServerParameters params;
+	TestServerPayload payload;
+	QHash<QTcpSocket*, StreamRequest> requests;
+	QHash<QTcpSocket*, TestServerPayload> requestedPayloads; //created from the full payload when it is first sent
+	QHash<QTcpSocket*, QByteArray> commandBuffers;
+	quint64 sequenceNumber;
+	QAtomicInt serverPort;
+	QAtomicInt bytesToWrite;
+
+	void createPayload();
+	TestServerPayload createRequestedPayload(const StreamRequest& request) const;
+	const TestServerPayload& payloadFor(QTcpSocket* client);
+	QByteArray createHeader(const TestServerPayload& payload, quint64 sequenceNumber, qint64 timestampUs) const;
+
+public slots:
+	bool listen(quint16 port);
+	void setParams(TestServerParameters params);
+	void startStreaming();
+	void stopStreaming();
+
+private slots:
+	void onNewConnection();
+	void readCommands();
+	void sendBuffer();
+
+signals:
+	void info(QString);
+};
+
+#endif // TESTSERVER_H
@@ -0,0 +1,312 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "threadtuning.h"
+#include <QCommandLineParser>
+#include <QFile>
+#include <QDebug>
+#include <QBitArray>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+#define NUMA_MASK_WORDS 16 //supports up to 1024 NUMA nodes
+
+//cpus that can be part of an affinity mask
+#if defined(Q_OS_LINUX)
+#define MAX_CPUS CPU_SETSIZE
+#elif defined(Q_OS_WIN)
+#define MAX_CPUS static_cast<int>(sizeof(DWORD_PTR) * 8)
+#else
+#define MAX_CPUS 1024
+#endif
+
+
+ThreadTuning::ThreadTuning()
+{
+	this->numaNode = -1;
+	this->policy = DefaultPolicy;
+	this->priority = 0;
+}
+
+bool ThreadTuning::isDefault() const {
+	return this->cpus.isEmpty() && this->numaNode < 0 && this->policy == DefaultPolicy;
+}
+
+QString ThreadTuning::toString() const {
+	QStringList parts;
+	if(!this->cpus.isEmpty()){
+		QStringList cpuNumbers;
+		for(int cpu : this->cpus){
+			cpuNumbers << QString::number(cpu);
+		}
+		parts << "cpus " + cpuNumbers.join(',');
+	}
+	if(this->numaNode >= 0){
+		parts << QString("numa node %1").arg(this->numaNode);
+	}
+	if(this->policy == NicePolicy){
+		parts << QString("nice %1").arg(this->priority);
+	}else if(this->policy == FifoPolicy){
+		parts << QString("SCHED_FIFO %1").arg(this->priority);
+	}
+	return parts.isEmpty() ? QString("default") : parts.join(", ");
+}
+
+bool ThreadTuning::apply(const QString& threadName) const {
+	if(this->isDefault()){
+		return true;
+	}
+	bool applied = true;
+	QList<int> threadCpus = this->cpus;
+	if(threadCpus.isEmpty() && this->numaNode >= 0){
+		threadCpus = cpusOfNumaNode(this->numaNode);
+		if(threadCpus.isEmpty()){
+			qWarning() << "ThreadTuning:" << threadName << "could not determine the cores of NUMA node" << this->numaNode;
+			applied = false;
+		}
+	}
+
+#if defined(Q_OS_LINUX)
+	if(!threadCpus.isEmpty()){
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		for(int cpu : threadCpus){
+			if(cpu < CPU_SETSIZE){
+				CPU_SET(cpu, &cpuSet);
+			}
+		}
+		int result = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+		if(result != 0){
+			qWarning() << "ThreadTuning:" << threadName << "could not set CPU affinity:" << strerror(result);
+			applied = false;
+		}
+	}
+	if(this->numaNode >= 0){
+		//frame buffers are allocated and first written by the receiver thread, so its memory policy decides where they are placed
+		const int bitsPerWord = static_cast<int>(sizeof(unsigned long) * 8);
+		unsigned long nodeMask[NUMA_MASK_WORDS] = {};
+		if(this->numaNode < NUMA_MASK_WORDS * bitsPerWord){
+			nodeMask[this->numaNode / bitsPerWord] = 1UL << (this->numaNode % bitsPerWord);
+		}
+		if(syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodeMask, static_cast<unsigned long>(NUMA_MASK_WORDS * bitsPerWord + 1)) != 0){
+			qWarning() << "ThreadTuning:" << threadName << "could not set NUMA memory policy:" << strerror(errno);
+			applied = false;
+		}
+	}
+	if(this->policy == FifoPolicy){
+		sched_param param = {};
+		param.sched_priority = this->priority;
+		int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if(result != 0){
+			qWarning() << "ThreadTuning:" << threadName << "could not set SCHED_FIFO priority" << this->priority << ":" << strerror(result);
+			applied = false;
+		}
+	}else if(this->policy == NicePolicy){
+		//nice values apply to single threads on Linux
+		if(setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), this->priority) != 0){
+			qWarning() << "ThreadTuning:" << threadName << "could not set nice value" << this->priority << ":" << strerror(errno);
+			applied = false;
+		}
+	}
+#elif defined(Q_OS_WIN)
+	if(!threadCpus.isEmpty()){
+		DWORD_PTR mask = 0;
+		for(int cpu : threadCpus){
+			if(cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)){
+				mask |= static_cast<DWORD_PTR>(1) << cpu;
+			}
+		}
+		if(SetThreadAffinityMask(GetCurrentThread(), mask) == 0){
+			qWarning() << "ThreadTuning:" << threadName << "could not set CPU affinity, error" << GetLastError();
+			applied = false;
+		}
+	}
+	if(this->numaNode >= 0){
+		qWarning() << "ThreadTuning:" << threadName << "NUMA nodes are not supported on Windows, use explicit cores instead";
+		applied = false;
+	}
+	if(this->policy != DefaultPolicy){
+		//Windows has no SCHED_FIFO, nice values are mapped to the nearest thread priority
+		int threadPriority = THREAD_PRIORITY_TIME_CRITICAL;
+		if(this->policy == NicePolicy){
+			if(this->priority <= -10){
+				threadPriority = THREAD_PRIORITY_HIGHEST;
+			}else if(this->priority < 0){
+				threadPriority = THREAD_PRIORITY_ABOVE_NORMAL;
+			}else if(this->priority >= 10){
+				threadPriority = THREAD_PRIORITY_LOWEST;
+			}else if(this->priority > 0){
+				threadPriority = THREAD_PRIORITY_BELOW_NORMAL;
+			}else{
+				threadPriority = THREAD_PRIORITY_NORMAL;
+			}
+		}
+		if(!SetThreadPriority(GetCurrentThread(), threadPriority)){
+			qWarning() << "ThreadTuning:" << threadName << "could not set thread priority, error" << GetLastError();
+			applied = false;
+		}
+	}
+#else
+	qWarning() << "ThreadTuning:" << threadName << "thread tuning is not supported on this platform";
+	applied = false;
+#endif
+
+	if(applied){
+		qDebug() << "ThreadTuning:" << threadName << "thread uses" << this->toString();
+	}
+	return applied;
+}
+
+void ThreadTuning::applyToThreadOf(QObject* object, const QString& threadName) const {
+	if(object == nullptr || this->isDefault()){
+		return;
+	}
+	ThreadTuning tuning = *this;
+	QMetaObject::invokeMethod(object, [tuning, threadName]() { tuning.apply(threadName); }, Qt::QueuedConnection);
+}
+
+bool ThreadTuning::parseCpuList(const QString& text, QList<int>& cpus) {
+	//same format as the Linux cpulist files, e.g. "0,2-3"
+	cpus.clear();
+	QBitArray selected(MAX_CPUS);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+	const QStringList ranges = text.trimmed().split(',', Qt::SkipEmptyParts);
+#else
+	const QStringList ranges = text.trimmed().split(',', QString::SkipEmptyParts);
+#endif
+	for(const QString& range : ranges){
+		QStringList bounds = range.trimmed().split('-');
+		bool firstOk = false;
+		bool lastOk = false;
+		int first = bounds.first().toInt(&firstOk);
+		int last = bounds.size() == 2 ? bounds.last().toInt(&lastOk) : first;
+		if(bounds.size() == 1){
+			lastOk = firstOk;
+		}
+		if(!firstOk || !lastOk || bounds.size() > 2 || first < 0 || last < first || last >= MAX_CPUS){
+			cpus.clear();
+			return false;
+		}
+		for(int cpu = first; cpu <= last; cpu++){
+			if(!selected.testBit(cpu)){
+				selected.setBit(cpu);
+				cpus.append(cpu);
+			}
+		}
+	}
+	return !cpus.isEmpty();
+}
+
+bool ThreadTuning::parsePriority(const QString& text, Policy& policy, int& priority) {
+	//"nice:<value>" or "fifo:<priority>"
+	QStringList parts = text.trimmed().toLower().split(':');
+	bool ok = false;
+	if(parts.size() != 2){
+		return false;
+	}
+	int value = parts.at(1).toInt(&ok);
+	if(!ok){
+		return false;
+	}
+	if(parts.at(0) == "nice" && value >= -20 && value <= 19){
+		policy = NicePolicy;
+	}else if(parts.at(0) == "fifo" && value >= 1 && value <= 99){
+		policy = FifoPolicy;
+	}else{
+		return false;
+	}
+	priority = value;
+	return true;
+}
+
+QList<int> ThreadTuning::cpusOfNumaNode(int node) {
+	QList<int> cpus;
+#ifdef Q_OS_LINUX
+	QFile cpuListFile(QString("/sys/devices/system/node/node%1/cpulist").arg(node));
+	if(cpuListFile.open(QIODevice::ReadOnly | QIODevice::Text)){
+		parseCpuList(QString::fromLatin1(cpuListFile.readAll()), cpus);
+	}
+#else
+	Q_UNUSED(node)
+#endif
+	return cpus;
+}
+
+
+
+void ThreadSettings::addOptions(QCommandLineParser& parser) {
+	parser.addOption(QCommandLineOption("receiver-cpus", "Cores the receiver thread may run on, e.g. 2 or 2-3.", "cpus"));
+	parser.addOption(QCommandLineOption("converter-cpus", "Cores the converter thread may run on.", "cpus"));
+	parser.addOption(QCommandLineOption("receiver-priority", "Priority of the receiver thread: nice:<-20..19> or fifo:<1..99>.", "priority"));
+	parser.addOption(QCommandLineOption("converter-priority", "Priority of the converter thread: nice:<-20..19> or fifo:<1..99>.", "priority"));
+	parser.addOption(QCommandLineOption("worker-cpus", "Cores the filter worker threads may run on.", "cpus"));
+	parser.addOption(QCommandLineOption("worker-priority", "Priority of the filter worker threads: nice:<-20..19> or fifo:<1..99>.", "priority"));
+	parser.addOption(QCommandLineOption("numa-node", "Run receiver, converter and filter workers on the cores of this NUMA node (unless cores are given) and allocate frame memory there.", "node"));
+}
+
+bool ThreadSettings::fromParser(const QCommandLineParser& parser, QString& errorMessage) {
+	struct ThreadOptions {
+		QString name;
+		ThreadTuning* tuning;
+	} threads[] = {{"receiver", &this->receiver}, {"converter", &this->converter}, {"worker", &this->worker}};
+
+	int numaNode = -1;
+	if(parser.isSet("numa-node")){
+		bool ok = false;
+		numaNode = parser.value("numa-node").toInt(&ok);
+		if(!ok || numaNode < 0){
+			errorMessage = "Invalid NUMA node " + parser.value("numa-node");
+			return false;
+		}
+	}
+	for(const ThreadOptions& thread : threads){
+		thread.tuning->numaNode = numaNode;
+		QString cpusOption = thread.name + "-cpus";
+		QString priorityOption = thread.name + "-priority";
+		if(parser.isSet(cpusOption) && !ThreadTuning::parseCpuList(parser.value(cpusOption), thread.tuning->cpus)){
+			errorMessage = QString("Invalid --%1 %2").arg(cpusOption, parser.value(cpusOption));
+			return false;
+		}
+		if(parser.isSet(priorityOption) && !ThreadTuning::parsePriority(parser.value(priorityOption), thread.tuning->policy, thread.tuning->priority)){
+			errorMessage = QString("Invalid --%1 %2").arg(priorityOption, parser.value(priorityOption));
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,75 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef THREADTUNING_H
+#define THREADTUNING_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QObject>
+
+class QCommandLineParser;
+
+//CPU affinity, scheduling priority and NUMA memory placement of one processing thread. Everything is off by default, options that are not permitted (e.g. SCHED_FIFO without CAP_SYS_NICE or an rtprio limit) are reported and skipped.
+struct ThreadTuning {
+	enum Policy {
+		DefaultPolicy,
+		NicePolicy,
+		FifoPolicy
+	};
+
+	QList<int> cpus; //cores the thread may run on, empty means no restriction
+	int numaNode; //-1 for no node, otherwise the thread runs on the cores of this node (unless cpus are given) and prefers memory of this node
+	Policy policy;
+	int priority; //nice value or SCHED_FIFO priority (1 - 99)
+
+	ThreadTuning();
+	bool isDefault() const;
+	QString toString() const;
+
+	//applies the settings to the calling thread
+	bool apply(const QString& threadName) const;
+	//applies the settings to the thread the object lives in
+	void applyToThreadOf(QObject* object, const QString& threadName) const;
+
+	static bool parseCpuList(const QString& text, QList<int>& cpus);
+	static bool parsePriority(const QString& text, Policy& policy, int& priority);
+	static QList<int> cpusOfNumaNode(int node);
+};
+
+
+//thread options of the receiver, converter and filter worker threads from the command line
+struct ThreadSettings {
+	ThreadTuning receiver;
+	ThreadTuning converter;
+	ThreadTuning worker; //shared by all threads of the filter WorkerPool
+
+	static void addOptions(QCommandLineParser& parser);
+	bool fromParser(const QCommandLineParser& parser, QString& errorMessage);
+};
+
+#endif // THREADTUNING_H
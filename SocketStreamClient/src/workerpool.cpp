@@ -0,0 +1,167 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+
+#include "workerpool.h"
+#include <QMutexLocker>
+
+class WorkerThread : public QThread
+{
+public:
+	WorkerThread(WorkerPool* pool, int index) : pool(pool), index(index) {}
+
+protected:
+	void run() override {
+		int taskGeneration = 0;
+		int tuningGeneration = 0;
+		this->pool->work(taskGeneration, tuningGeneration, this->index);
+	}
+
+private:
+	WorkerPool* pool;
+	int index;
+};
+
+
+WorkerPool::WorkerPool(int threadCount)
+{
+	this->currentTask = nullptr;
+	this->currentCount = 0;
+	this->generation = 0;
+	this->completedTiles = 0;
+	this->busyWorkers = 0;
+	this->stopping = false;
+	this->tuningGeneration = 0;
+	for(int i = 1; i < threadCount; i++){
+		WorkerThread* worker = new WorkerThread(this, i);
+		worker->start();
+		this->workers.append(worker);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		QMutexLocker locker(&this->mutex);
+		this->stopping = true;
+		this->workAvailable.wakeAll();
+	}
+	for(WorkerThread* worker : this->workers){
+		worker->wait();
+		delete worker;
+	}
+}
+
+void WorkerPool::setThreadTuning(const ThreadTuning& tuning) {
+	QMutexLocker locker(&this->mutex);
+	this->tuning = tuning;
+	this->tuningGeneration++;
+	this->workAvailable.wakeAll();
+}
+
+void WorkerPool::run(int count, const std::function<void(int)>& task) {
+	if(count <= 0){
+		return;
+	}
+	if(this->workers.isEmpty() || count == 1){
+		for(int i = 0; i < count; i++){
+			task(i);
+		}
+		return;
+	}
+	{
+		QMutexLocker locker(&this->mutex);
+		this->currentTask = &task;
+		this->currentCount = count;
+		this->completedTiles = 0;
+		this->nextTile.storeRelease(0);
+		this->generation++;
+		this->workAvailable.wakeAll();
+	}
+	this->runTiles(&task, count);
+
+	//workers that picked up this task may still read it, wait for them before the task goes out of scope
+	QMutexLocker locker(&this->mutex);
+	while(this->completedTiles < count || this->busyWorkers > 0){
+		this->workFinished.wait(&this->mutex);
+	}
+	this->currentTask = nullptr;
+	this->currentCount = 0;
+}
+
+void WorkerPool::runTiles(const std::function<void(int)>* task, int count) {
+	int completed = 0;
+	while(true){
+		int tile = this->nextTile.fetchAndAddRelaxed(1);
+		if(tile >= count){
+			break;
+		}
+		(*task)(tile);
+		completed++;
+	}
+	QMutexLocker locker(&this->mutex);
+	this->completedTiles += completed;
+	if(this->completedTiles >= count){
+		this->workFinished.wakeAll();
+	}
+}
+
+void WorkerPool::work(int& taskGeneration, int& tuningGeneration, int workerIndex) {
+	QMutexLocker locker(&this->mutex);
+	while(true){
+		while(!this->stopping && taskGeneration == this->generation && tuningGeneration == this->tuningGeneration){
+			this->workAvailable.wait(&this->mutex);
+		}
+		if(this->stopping){
+			return;
+		}
+		if(tuningGeneration != this->tuningGeneration){
+			tuningGeneration = this->tuningGeneration;
+			ThreadTuning tuning = this->tuning;
+			locker.unlock();
+			tuning.apply(QString("worker %1").arg(workerIndex));
+			locker.relock();
+		}
+		if(taskGeneration == this->generation){
+			continue;
+		}
+		taskGeneration = this->generation;
+		//a worker that wakes up after the task has finished finds no task or no tiles left
+		const std::function<void(int)>* task = this->currentTask;
+		int count = this->currentCount;
+		if(task == nullptr){
+			continue;
+		}
+		this->busyWorkers++;
+		locker.unlock();
+		this->runTiles(task, count);
+		locker.relock();
+		this->busyWorkers--;
+		if(this->busyWorkers == 0){
+			this->workFinished.wakeAll();
+		}
+	}
+}
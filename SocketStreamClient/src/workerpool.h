@@ -0,0 +1,76 @@
+/**
+**  This file is part of Socket Stream Client.
+**  Socket Stream Client can be used to test Socket Stream Extension for OCTproZ
+**  Copyright (C) 2024 Miroslav Zabic
+**
+**  Socket Stream Client is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <functional>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QList>
+#include "threadtuning.h"
+
+class WorkerThread;
+
+//Fixed set of threads that run the tiles of one parallel task at a time. The calling thread takes part, tiles are handed out dynamically so uneven tiles do not stall the task.
+class WorkerPool
+{
+public:
+	explicit WorkerPool(int threadCount = QThread::idealThreadCount());
+	~WorkerPool();
+
+	int threadCount() const { return this->workers.size() + 1; }
+	//applied by every worker thread before it runs its next task
+	void setThreadTuning(const ThreadTuning& tuning);
+	//calls task(i) for every i in [0, count) and returns when all calls are finished
+	void run(int count, const std::function<void(int)>& task);
+
+private:
+	friend class WorkerThread;
+	void work(int& taskGeneration, int& tuningGeneration, int workerIndex);
+	void runTiles(const std::function<void(int)>* task, int count);
+
+	QList<WorkerThread*> workers;
+	QMutex mutex;
+	QWaitCondition workAvailable;
+	QWaitCondition workFinished;
+	const std::function<void(int)>* currentTask;
+	int currentCount;
+	int generation;
+	int completedTiles;
+	int busyWorkers;
+	bool stopping;
+	QAtomicInt nextTile;
+	ThreadTuning tuning;
+	int tuningGeneration;
+
+	Q_DISABLE_COPY(WorkerPool)
+};
+
+#endif // WORKERPOOL_H